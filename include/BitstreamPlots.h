@@ -0,0 +1,19 @@
+#ifndef BITSTREAM_PLOTS_H_
+#define BITSTREAM_PLOTS_H_
+
+/**
+ * The public API of libbitstreamplots. Include this header to use
+ * the extraction engine from other C++ code or from the Python
+ * bindings (python/bitstreamplots.py).
+ */
+
+#include "DataFrameProjection.h"
+#include "DirectoryParser.h"
+#include "HistStack.h"
+#include "LumiBlockVeto.h"
+#include "PileUpExtractor.h"
+#include "PileUpHistogram.h"
+#include "PixelModules.h"
+#include "RunIndex.h"
+
+#endif  // BITSTREAM_PLOTS_H_
@@ -0,0 +1,84 @@
+#ifndef DATA_FRAME_PROJECTION_H_
+#define DATA_FRAME_PROJECTION_H_
+
+#include <memory>
+#include <set>
+#include <vector>
+
+class TProfile;
+
+/**
+ * An alternative to the per-module PileUpHistogram objects: the
+ * LB data of all modules (and metrics) is first flattened into a
+ * columnar dataset with one row per module and LB, holding the
+ * columns (module, LB, pile-up, occupancy, entries). The veto
+ * and the pile-up projection are then booked as lazy actions of
+ * one ROOT::RDataFrame. Any number of module selections (e.g.
+ * one per module group) can be booked, which are all filled in a
+ * single event loop by run(). This loop uses implicit
+ * multithreading if enabled (see ROOT::EnableImplicitMT()). The
+ * results are identical to those of PileUpHistogram, up to the
+ * summation order of the values.
+ */
+class DataFrameProjection {
+public:
+  /// The columns of the dataset, one entry per module and LB.
+  struct Columns {
+    std::vector<unsigned int> module{};
+    std::vector<int> lb{};
+    std::vector<double> pile_up{};
+    std::vector<double> occupancy{};
+    std::vector<double> entries{};
+  };
+
+  /**
+   * Set up the (empty) dataset.
+   * @param pile_up_min The lower edge of the pile-up axis
+   * @param pile_up_max The upper edge of the pile-up axis
+   * @param pile_up_bins The number of pile-up bins
+   * @param vetoed_lbs The luminosity blocks to skip
+   */
+  DataFrameProjection(double pile_up_min, double pile_up_max, int pile_up_bins,
+                      std::shared_ptr<const std::set<int> > vetoed_lbs);
+
+  /// The data frame refers to the columns held by this object,
+  /// which therefore can be neither copied nor moved.
+  DataFrameProjection(const DataFrameProjection&) = delete;
+  DataFrameProjection& operator=(const DataFrameProjection&) = delete;
+  ~DataFrameProjection();
+
+  /// Add the LB data of one module to the dataset, given the
+  /// pile-up value per LB. Returns the index of the module. All
+  /// modules must be added before the first booking.
+  std::size_t addModule(const TProfile& prof, const std::vector<double>& pile_up);
+
+  /// Book the projection of a selection of modules, given as one
+  /// flag per module index. Returns the index of the booking.
+  std::size_t book(const std::vector<bool>& modules);
+
+  /// Get the number of modules in the dataset.
+  std::size_t getNModules() const { return m_n_modules; }
+
+  /// Get the values of a booking per module and pile-up bin
+  /// (row-major, see ModuleTable). The rows of all modules that
+  /// are not part of the selection hold zeros. The event loop is
+  /// run first, if that did not happen yet.
+  std::vector<double> getValues(std::size_t booking) const;
+
+  /// Run the event loop once for all bookings.
+  void run();
+
+private:
+  /// The data frame and all booked actions.
+  struct Frame;
+
+  Columns m_columns{};
+  std::size_t m_n_modules{0};
+  double m_pile_up_min{0.};
+  double m_pile_up_max{20.};
+  int m_pile_up_bins{10};
+  std::shared_ptr<const std::set<int> > m_vetoed_lbs{nullptr};
+  std::unique_ptr<Frame> m_frame{nullptr};
+};
+
+#endif  // DATA_FRAME_PROJECTION_H_
@@ -1,6 +1,8 @@
 #ifndef DIRECTORYPARSER_H_
 #define DIRECTORYPARSER_H_
 
+#include "PixelModules.h"
+
 #include <set>
 #include <string>
 
@@ -25,8 +27,11 @@ public:
    * @param file The TFile object to be parsed
    * @param path The path within the TFile to be parsed
    * @param wildcard An additional wildcard to filter results
+   * @param folder The monitoring folder (relative to the path,
+   *   with trailing slash) that holds the module histograms
    */
-  DirectoryParser(TFile* file, const std::string& path, const std::string& wildcard = "");
+  DirectoryParser(TFile* file, const std::string& path, const std::string& wildcard = "",
+                  const std::string& folder = kDefaultMetric);
 
   /// Set of all module names found during parsing.
   std::set<std::string> modules;
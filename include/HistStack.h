@@ -6,8 +6,10 @@
 #include <vector>
 
 class TCanvas;
+class TGraphAsymmErrors;
 class TH1D;
 class TLegend;
+class TVirtualPad;
 
 class HistStack {
  public:
@@ -16,23 +18,63 @@ class HistStack {
    * to TH1D objects. This effectively releases the histograms in
    * that vector and transfers ownership to this object. This
    * constructor also takes care of basic settings, such as
-   * colors and markers. An additional maximal value for the
-   * X-axis can be given to limit the plotting range.
+   * colors and markers. Up to seven histograms get the classic
+   * style set; for larger stacks (e.g. one histogram per stave)
+   * colors and markers are generated automatically (see also
+   * useAutoStyles()). An additional maximal value for the X-axis
+   * can be given to limit the plotting range.
    * @param histos Vector with TH1D unique pointers
    * @param x_max Optional maximal x value for plotting
    */
   HistStack(std::vector<std::unique_ptr<TH1D> >& histos, double x_max = 0);
 
-  /// Create the legend based on the containing histograms.
-  void createLegend(TLegend* legend);
+  ~HistStack();
 
-  /// Draw all histograms on the given canvas. If no custom
+  /// Shift all histograms automatically, such that the data
+  /// points of one page are spread evenly over 'total_spread'
+  /// (in fractions of the bin width, see shift()). If
+  /// 'per_page' is zero, all histograms count as one page.
+  void autoShift(float total_spread, unsigned int per_page = 0);
+
+  /// Create the legend based on the containing histograms. If
+  /// 'per_page' is non-zero, only the histograms of the given
+  /// page are added (see drawPage()).
+  void createLegend(TLegend* legend, unsigned int page = 0, unsigned int per_page = 0);
+
+  /// Draw all histograms on the given canvas or pad. If no custom
   /// maximal value is set via setComfortableMax(), this function
   /// also determines the optimal plotting range.
-  void draw(TCanvas* canvas);
+  void draw(TVirtualPad* pad);
+
+  /// Draw a summary of all histograms instead of the individual
+  /// series: a band spanning the minimal and maximal bin content
+  /// of all histograms, together with the mean of all series.
+  void drawEnvelope(TVirtualPad* pad);
+
+  /// Draw the ratios of all histograms to the reference
+  /// histogram (given by its index) on the given pad, e.g. as a
+  /// ratio panel below the pad used by draw().
+  void drawRatio(TVirtualPad* pad, unsigned int reference = 0, double min = 0.8, double max = 1.2);
+
+  /// Draw one page of histograms, i.e. the histograms with
+  /// indices [page * per_page, (page + 1) * per_page), on the
+  /// given pad. The frame is shared by all pages.
+  void drawPage(TVirtualPad* pad, unsigned int page, unsigned int per_page);
 
-  /// Get the maximal entry in all histograms.
-  double getMax() const;
+  /// Divide the canvas into as many pads as there are pages with
+  /// 'per_page' histograms each and draw one page per pad. With
+  /// 'legends', each pad also gets a legend of its histograms.
+  void drawPaged(TCanvas* canvas, unsigned int per_page, bool legends = false);
+
+  /// Get the maximal entry in all histograms. The value is
+  /// determined once on construction.
+  double getMax() const { return max_; }
+
+  /// Get the number of pages with 'per_page' histograms each.
+  unsigned int getNPages(unsigned int per_page) const;
+
+  /// Get the number of histograms in this container.
+  unsigned int getSize() const { return histograms_.size(); }
 
   /// Print a table of all histogram bin contents.
   std::string printTable() const;
@@ -52,6 +94,12 @@ class HistStack {
   /// Set the Y-axis title for all histograms simultaneously.
   void setYAxisTitle(const std::string& title);
 
+  /// Use the automatically generated colors and markers for all
+  /// histograms, also for stacks of up to seven histograms (e.g.
+  /// to tell apart a few streams by their color). This must be
+  /// called before drawing any ratios.
+  void useAutoStyles();
+
   /// Shift histograms in this container by a given fraction
   /// (negative: to the left, positive: to the right) to avoid
   /// overlap of data points. The size of the given vector must
@@ -61,14 +109,43 @@ class HistStack {
   void shift(const std::vector<float>& shift_values);
 
  private:
+  /// Set colors and markers of all histograms, either from the
+  /// classic style set or generated automatically.
+  void applyStyles(bool classic);
+
+  /// Create the (empty) frame histogram, if not done yet. The
+  /// frame carries the axes and is drawn once per pad.
+  void buildFrame();
+
   /// The histogram titles, to be used in the legend.
   std::vector<std::string> titles_;
 
   /// Vector of all histograms this container holds.
   std::vector<std::unique_ptr<TH1D>> histograms_;
 
+  /// The frame histogram holding the axes for all pads.
+  std::unique_ptr<TH1D> frame_;
+
+  /// The ratio histograms and their frame, see drawRatio().
+  std::vector<std::unique_ptr<TH1D>> ratios_;
+  std::unique_ptr<TH1D> ratio_frame_;
+
+  /// The legends of all pads, see drawPaged().
+  std::vector<std::unique_ptr<TLegend>> legends_;
+
+  /// The envelope band and mean, see drawEnvelope().
+  std::unique_ptr<TGraphAsymmErrors> envelope_;
+  std::unique_ptr<TH1D> envelope_mean_;
+
   /// Boolean whether a custom maximal value was set.
   bool has_custom_max_{false};
+
+  /// The maximal entry in all histograms.
+  double max_{0.};
+
+  /// The X-axis limits before any shifting.
+  double x_min_{0.};
+  double x_max_{0.};
 };
 
 #endif  // HISTSTACK_H_
@@ -0,0 +1,63 @@
+#ifndef LUMI_BLOCK_VETO_H_
+#define LUMI_BLOCK_VETO_H_
+
+#include "PixelModules.h"
+
+#include <set>
+#include <string>
+#include <vector>
+
+class TFile;
+
+/**
+ * A class to find the luminosity blocks that should be vetoed,
+ * based on the LB activity of all modules. On construction, the
+ * per-LB entries and occupancies of all given modules are copied
+ * into contiguous module x LB arrays. A single pass over these
+ * arrays then yields the total entries and the mean occupancy
+ * per LB. An LB is vetoed if the stream is (nearly) inactive,
+ * i.e. its entries are far below the median of all active LBs,
+ * or if its mean occupancy is anomalous. As the occupancy rises
+ * with the pile-up, a straight line is fitted to the occupancy
+ * vs. pile-up of all active LBs first. An LB is anomalous if its
+ * residual deviates from the median residual by more than a
+ * given number of median absolute deviations.
+ */
+class LumiBlockVeto {
+public:
+  /**
+   * Read the luminosity-block histograms of all given modules
+   * and the pile-up per LB. The input histograms are not modified.
+   * @param file The TFile object from where to read
+   * @param path The path to the Pixel directory of the run
+   * @param modules The modules to take into account
+   * @param folder The monitoring folder (relative to the path,
+   *   with trailing slash) that holds the module histograms
+   */
+  LumiBlockVeto(TFile* file, const std::string& path, const std::set<std::string>& modules,
+                const std::string& folder = kDefaultMetric);
+
+  /// Find all luminosity blocks that should be vetoed. The vetoed
+  /// LB ranges are printed.
+  std::set<int> findVetoedLumiBlocks() const;
+
+  /// Set the maximal deviation of the occupancy residual of an LB
+  /// from the median residual, in units of the (scaled) median absolute
+  /// deviation.
+  void setMaxDeviation(double n_mad);
+
+  /// Set the minimal activity of an LB, as fraction of the
+  /// median number of entries of all active LBs.
+  void setMinActivity(double fraction);
+
+private:
+  std::vector<double> m_entries{};
+  std::vector<double> m_occupancies{};
+  std::vector<double> m_pile_up{};
+  std::size_t m_n_modules{0};
+  std::size_t m_n_lbs{0};
+  double m_max_deviation{5.};
+  double m_min_activity{0.1};
+};
+
+#endif  // LUMI_BLOCK_VETO_H_
@@ -0,0 +1,135 @@
+#ifndef PILE_UP_EXTRACTOR_H_
+#define PILE_UP_EXTRACTOR_H_
+
+#include "PixelModules.h"
+
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+class TFile;
+class TH1D;
+
+/**
+ * The per-module results of the pile-up projection. Each row
+ * holds one module, each column one pile-up bin. All values are
+ * stored contiguously in row-major order, such that they can be
+ * viewed without copying (e.g. as NumPy arrays, see python/).
+ */
+struct ModuleTable {
+  /// Get the value of a given module (row) and pile-up bin (column).
+  double at(std::size_t module, std::size_t bin) const { return values.at(module * bin_centers.size() + bin); }
+
+  /// Get the number of modules (rows).
+  std::size_t getNModules() const { return modules.size(); }
+
+  /// Get the number of pile-up bins (columns).
+  std::size_t getNBins() const { return bin_centers.size(); }
+
+  /// Find the column of a given pile-up value. Returns -1 if the
+  /// value is outside of the pile-up range.
+  int findBin(double pile_up) const;
+
+  std::string metric{""};
+  std::vector<std::string> modules{};
+  std::vector<double> bin_centers{};
+  std::vector<double> values{};
+  double pile_up_min{0.};
+  double pile_up_max{0.};
+};
+
+/**
+ * A class to run the pile-up projection (see PileUpHistogram)
+ * for all modules matching a wildcard (see DirectoryParser) and
+ * to reduce the per-module results to summary histograms. Several
+ * per-module metrics (i.e. monitoring folders) can be extracted
+ * in one go, sharing the pile-up values and the vetoed LBs.
+ */
+class PileUpExtractor {
+public:
+  /// The available backends: the per-module key walk with one
+  /// PileUpHistogram per module, or the columnar dataset that is
+  /// projected with ROOT::RDataFrame (see DataFrameProjection).
+  enum class Backend { kKeyWalk, kDataFrame };
+
+  /**
+   * Set up the extraction for one file.
+   * @param file The TFile object from where to read
+   * @param path The path to the Pixel directory of the run
+   */
+  PileUpExtractor(TFile* file, const std::string& path);
+
+  /// Extract the pile-up projections of all modules matching the
+  /// given wildcard, for the first metric only.
+  ModuleTable extract(const std::string& wildcard) const;
+
+  /// Extract the pile-up projections of all modules matching the
+  /// given wildcard for all metrics in one traversal. All metrics
+  /// of one module are read together. Returns one table per
+  /// metric, in the order given to setMetrics().
+  std::vector<ModuleTable> extractAll(const std::string& wildcard) const;
+
+  /// Extract the pile-up projections of all modules in the given
+  /// groups for all metrics. The modules of all groups are read
+  /// in one traversal (and, with the RDataFrame backend, projected
+  /// in one event loop). Returns one table per metric and group,
+  /// i.e. tables[metric][group].
+  std::vector<std::vector<ModuleTable> > extractGroups(const std::vector<ModuleGroup>& groups) const;
+
+  /// Only keep the modules of a table that match the wildcard.
+  ModuleTable filter(const ModuleTable& table, const std::string& wildcard) const;
+
+  /// Get the monitoring folders of all metrics.
+  const std::vector<std::string>& getMetrics() const { return m_metrics; }
+
+  /// Get the values of all modules at the given pile-up value.
+  /// Modules without a value at that pile-up are skipped.
+  std::vector<double> getModuleValues(const ModuleTable& table, float pile_up) const;
+
+  /// Reduce the information of all modules in the table to _one_
+  /// histogram, averaging over all modules per pile-up bin.
+  std::unique_ptr<TH1D> makeReducedHist(const ModuleTable& table, const std::string& title) const;
+
+  /// Choose the backend for all following extractions.
+  void setBackend(Backend backend) { m_backend = backend; }
+
+  /// Set the metrics to extract, given as monitoring folders
+  /// relative to the Pixel directory (e.g. kDefaultMetric). Each
+  /// folder must hold one TProfile vs. LB per module, see
+  /// DirectoryParser.
+  void setMetrics(const std::vector<std::string>& metrics);
+
+  /// Set the range of the pile-up axis.
+  void setPileUpRange(float min, float max);
+
+  /// Veto a set of luminosity blocks for all modules. The
+  /// resulting set is shared by all per-module histograms.
+  void vetoLumiBlocks(const std::set<int>& lbs);
+
+private:
+  /// Extract the given metrics in one traversal.
+  std::vector<ModuleTable> extractMetrics(const std::string& wildcard, const std::vector<std::string>& metrics) const;
+
+  /// Extract the given metrics with the RDataFrame backend, with
+  /// one projection per group that is booked on the same data
+  /// frame. Returns one table per metric and group.
+  std::vector<std::vector<ModuleTable> > extractMetricsDataFrame(const std::string& wildcard, const std::vector<std::string>& metrics,
+                                                                 const std::vector<ModuleGroup>& groups) const;
+
+  /// Set up one empty table per metric and find the modules that
+  /// match the wildcard, per metric and for all metrics combined.
+  std::vector<ModuleTable> setUpTables(const std::string& wildcard, const std::vector<std::string>& metrics,
+                                       std::vector<std::set<std::string> >& metric_modules,
+                                       std::set<std::string>& all_modules) const;
+
+  std::string m_path{""};
+  Backend m_backend{Backend::kKeyWalk};
+  std::vector<std::string> m_metrics{kDefaultMetric};
+  std::shared_ptr<const std::set<int> > m_vetoed_lbs{std::make_shared<const std::set<int> >()};
+  double m_pile_up_min{0.};
+  double m_pile_up_max{20.};
+  TFile* m_file{nullptr};
+};
+
+#endif  // PILE_UP_EXTRACTOR_H_
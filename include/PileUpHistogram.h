@@ -1,9 +1,12 @@
 #ifndef PILE_UP_HISTOGRAM_H_
 #define PILE_UP_HISTOGRAM_H_
 
+#include "PixelModules.h"
+
 #include <memory>
 #include <set>
 #include <string>
+#include <vector>
 
 class TFile;
 class TH1D;
@@ -24,13 +27,33 @@ public:
    * @param path The path to the luminosity-block histogram
    * @param histo_name An additional histogram name that can be
    *   given to the resulting pile-up histogram
+   * @param folder The monitoring folder (relative to the path,
+   *   with trailing slash) that holds the histogram
    */
-  PileUpHistogram(TFile* file, const std::string& path, const std::string& histo_name);
+  PileUpHistogram(TFile* file, const std::string& path, const std::string& histo_name,
+                  const std::string& folder = kDefaultMetric);
+
+  /// Get the number of pile-up bins for the given range, i.e.
+  /// the number of full bins of width 5.
+  static int getPileUpBins(float min, float max);
+
+  /// Read the pile-up value of each luminosity block from the
+  /// given path. The returned vector is indexed by LB and can be
+  /// shared by all histograms, see setPileUpLookup().
+  static std::shared_ptr<const std::vector<double> > readPileUpLookup(TFile* file, const std::string& path);
 
   /// Perform the actual fill method for the histogram. This maps
   /// luminosity blocks to pile-up values.
   void fillHisto();
 
+  /// Use the given pile-up values per LB instead of reading them
+  /// from the file for each histogram.
+  void setPileUpLookup(std::shared_ptr<const std::vector<double> > lookup);
+
+  /// Use the given set of vetoed luminosity blocks. The set is
+  /// shared (and not copied), e.g. between all modules.
+  void setVetoedLumiBlocks(std::shared_ptr<const std::set<int> > lbs);
+
   /// Veto a set of luminosity blocks that don't contain "good"
   /// values, e.g. when the stream is not yet active.
   void vetoLumiBlocks(const std::set<int> lbs);
@@ -47,7 +70,9 @@ public:
 private:
   std::string m_path{""};
   std::string m_histo_name{""};
-  std::set<int> m_vetoed_lbs{};
+  std::string m_folder{""};
+  std::shared_ptr<const std::vector<double> > m_pile_up_lookup{nullptr};
+  std::shared_ptr<const std::set<int> > m_vetoed_lbs{nullptr};
   double m_pile_up_min{0.};
   double m_pile_up_max{20.};
   int m_pile_up_bins{10};
@@ -0,0 +1,24 @@
+#ifndef PIXEL_MODULES_H_
+#define PIXEL_MODULES_H_
+
+#include <string>
+#include <vector>
+
+/// The default per-module metric, i.e. the monitoring folder
+/// (relative to the Pixel directory, with trailing slash) that
+/// holds the bit-stream occupancy vs. LB of each module.
+extern const std::string kDefaultMetric;
+
+/// A group of modules that is reduced to one summary histogram,
+/// given by its title and the wildcard matching its modules.
+struct ModuleGroup {
+  std::string title{""};
+  std::string wildcard{""};
+};
+
+/// The groups shown in all summary plots: the three outer barrel
+/// layers, both end-caps (w/o two noisy ECC modules) and the
+/// planar and 3D sensors of the IBL.
+extern const std::vector<ModuleGroup> kPixelModuleGroups;
+
+#endif  // PIXEL_MODULES_H_
@@ -0,0 +1,91 @@
+#ifndef RUN_INDEX_H_
+#define RUN_INDEX_H_
+
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * A persistent index of monitoring files. For each file, this
+ * stores the run number (taken from the top-level "run_N" key),
+ * the stream, the LHC fill and the range of luminosity blocks
+ * with recorded pile-up values. The index is kept in a plain
+ * text file and can be updated incrementally: only files that
+ * are new or were modified since the last scan are opened.
+ *
+ * Neither the stream nor the fill number are stored inside the
+ * monitoring files. The stream is taken from the dataset name
+ * (e.g. "data18_13TeV.00356124.physics_ZeroBias.merge.HIST..."),
+ * the fill number from a run-to-fill table (see loadFillTable()
+ * and data/fills.txt). Once indexed, the fill of a run is kept,
+ * even if a later fill table does not contain that run.
+ */
+class RunIndex {
+public:
+  /// All information stored per indexed file.
+  struct Entry {
+    std::string file{""};
+    long modified{0};
+    long long size{0};
+    int run{0};
+    std::string stream{"???"};
+    std::string fill{"???"};
+    int lb_min{0};
+    int lb_max{0};
+  };
+
+  /**
+   * Create the index and load the content of the given index
+   * file, if it exists already.
+   * @param index_file The file where the index is kept
+   */
+  explicit RunIndex(const std::string& index_file);
+
+  /// Find the entry of a given file. Returns a null pointer if
+  /// the file is not indexed (yet).
+  const Entry* find(const std::string& file) const;
+
+  /// Find all files that hold the given run.
+  std::vector<const Entry*> findRun(int run) const;
+
+  /// Load run-to-fill pairs from a text file with two
+  /// whitespace-separated columns (run, fill) per line. Lines
+  /// starting with '#' are ignored.
+  void loadFillTable(const std::string& path);
+
+  /// Save the index to the index file given on construction, if
+  /// anything changed. The file is replaced atomically, so that
+  /// concurrent jobs always read a complete index.
+  void save();
+
+  /// Recursively walk through the given directory and index all
+  /// monitoring files that are new or have changed. Files that
+  /// vanished from that directory are removed from the index.
+  /// Throws if the directory itself cannot be read. Returns the
+  /// number of files that were (re)scanned.
+  unsigned int update(const std::string& directory);
+
+  /// Make sure that the given file is indexed and up to date,
+  /// then return its entry.
+  const Entry& updateFile(const std::string& file);
+
+private:
+  /// Add an entry to the lookup tables.
+  void insert(Entry entry);
+
+  /// Remove the entry of the given file from the lookup tables.
+  void remove(const std::string& file);
+
+  /// Open the given file and extract all information for its entry.
+  Entry scanFile(const std::string& file, long modified, long long size) const;
+
+  std::string m_index_file{""};
+  std::unordered_map<std::string, Entry> m_entries{};
+  std::unordered_map<int, std::set<std::string>> m_runs{};
+  std::map<int, std::string> m_fills{};
+  bool m_modified{false};
+};
+
+#endif  // RUN_INDEX_H_
@@ -0,0 +1,123 @@
+"""Python bindings for libbitstreamplots.
+
+The extraction engine of the shared library is loaded into PyROOT.
+The per-module results are exposed as NumPy arrays that view the
+contiguous buffers of the underlying C++ ModuleTable, i.e. they are
+not copied. Usage:
+
+    import bitstreamplots
+    extraction = bitstreamplots.Extraction("HIST.root", 356124)
+    results = extraction.extract("^LI.*_[AC][78]_")
+    print(results.modules[0], results.values[0, results.find_bin(40)])
+
+The arrays are only valid as long as the results object is alive.
+Build the library with 'make' and source setup.sh first, which puts
+this directory on the PYTHONPATH. All C++ classes remain available
+through ROOT (e.g. ROOT.HistStack, ROOT.RunIndex).
+"""
+
+import os
+
+import numpy as np
+import ROOT
+
+_TOP_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+
+def _load_library():
+    """Load the shared library and declare its public API."""
+    if ROOT.gSystem.Load(os.path.join(_TOP_DIR, "libbitstreamplots.so")) < 0:
+        raise ImportError("Could not load libbitstreamplots.so, run make first")
+    ROOT.gInterpreter.AddIncludePath(os.path.join(_TOP_DIR, "include"))
+    ROOT.gInterpreter.Declare('#include "BitstreamPlots.h"')
+
+
+_load_library()
+
+
+def _view(vector, shape):
+    """View the buffer of a std::vector<double> as NumPy array."""
+    size = int(np.prod(shape))
+    if size == 0:
+        return np.empty(shape)
+    buf = vector.data()
+    if hasattr(buf, "SetSize"):
+        buf.SetSize(size)
+    else:
+        buf.reshape((size,))
+    return np.frombuffer(buf, dtype=np.float64, count=size).reshape(shape)
+
+
+class ModuleResults(object):
+    """The per-module x pile-up-bin results of one extraction."""
+
+    def __init__(self, table, owner=None):
+        # Keep the table (or the vector of tables it belongs to), it
+        # owns the memory viewed by the arrays.
+        self.table = table
+        self._owner = owner
+        self.metric = str(table.metric)
+        self.modules = [str(module) for module in table.modules]
+        self.bin_centers = _view(table.bin_centers, (table.getNBins(),))
+        self.values = _view(table.values, (table.getNModules(), table.getNBins()))
+
+    def find_bin(self, pile_up):
+        """Get the column of a pile-up value (-1 if out of range)."""
+        return self.table.findBin(pile_up)
+
+
+class Extraction(object):
+    """Run the pile-up extraction on one monitoring file.
+
+    With dataframe=True, the RDataFrame backend is used. Its event
+    loop runs on all cores via ROOT.EnableImplicitMT(), unless
+    implicit_mt=False is given (e.g. if the caller manages the
+    thread pool itself).
+    """
+
+    def __init__(self, file_name, run, pile_up_range=(22.5, 57.5), veto=True, metrics=None,
+                 dataframe=False, implicit_mt=True):
+        self.file = ROOT.TFile.Open(file_name, "READ")
+        if not self.file or self.file.IsZombie():
+            raise IOError("Could not open file {}".format(file_name))
+        self.path = "run_{}/Pixel/".format(run)
+        if not self.file.GetDirectory(self.path):
+            raise ValueError("Directory {} does not exist. Check run number".format(self.path))
+
+        self.extractor = ROOT.PileUpExtractor(self.file, self.path)
+        self.extractor.setPileUpRange(*pile_up_range)
+        if dataframe:
+            if implicit_mt and not ROOT.IsImplicitMTEnabled():
+                ROOT.EnableImplicitMT()
+            self.extractor.setBackend(ROOT.PileUpExtractor.Backend.kDataFrame)
+        if metrics:
+            folders = ROOT.std.vector("std::string")()
+            for metric in metrics:
+                folders.push_back(metric)
+            self.extractor.setMetrics(folders)
+        self.vetoed_lbs = []
+        if veto:
+            parser = ROOT.DirectoryParser(self.file, self.path)
+            lbs = ROOT.LumiBlockVeto(self.file, self.path, parser.modules).findVetoedLumiBlocks()
+            self.extractor.vetoLumiBlocks(lbs)
+            self.vetoed_lbs = sorted(int(lb) for lb in lbs)
+
+    def extract(self, wildcard=""):
+        """Extract all modules matching the wildcard."""
+        return ModuleResults(self.extractor.extract(wildcard))
+
+    def extract_all(self, wildcard=""):
+        """Extract all metrics in one traversal, keyed by metric."""
+        tables = self.extractor.extractAll(wildcard)
+        return dict((str(table.metric), ModuleResults(table, tables)) for table in tables)
+
+    def extract_groups(self):
+        """Extract all metrics for the module groups of the summary
+        plots (ROOT.kPixelModuleGroups) in one go, keyed by metric
+        and group title."""
+        groups = ROOT.kPixelModuleGroups
+        tables = self.extractor.extractGroups(groups)
+        return dict((str(self.extractor.getMetrics()[k]),
+                     dict((str(groups[g].title), ModuleResults(tables[k][g], tables))
+                          for g in range(groups.size())))
+                    for k in range(tables.size()))
@@ -1 +1,2 @@
 setupATLAS --quiet && lsetup "git 2.11.1-x86_64-slc6" "root 6.14.04-x86_64-slc6-gcc62-opt"
+export PYTHONPATH="$(pwd)/python${PYTHONPATH:+:$PYTHONPATH}"
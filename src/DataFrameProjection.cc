@@ -0,0 +1,130 @@
+#include "DataFrameProjection.h"
+
+#include "ROOT/RDataFrame.hxx"
+#include "TAxis.h"
+#include "TH1D.h"
+#include "TProfile.h"
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace {
+// Define all columns of the dataset and the derived columns used
+// by every booking. Each (module, pile-up bin) pair is one cell
+// of a flat histogram, where the under- and overflow bins of the
+// pile-up axis get their own cells. Vetoed LBs and LBs without
+// entries or with zero occupancy are not selected, as in
+// PileUpHistogram (where LBs without entries have zero occupancy).
+auto defineColumns(ROOT::RDataFrame& frame, const DataFrameProjection::Columns& columns, const TAxis& axis,
+                   int n_columns, std::shared_ptr<const std::set<int> > vetoed_lbs) {
+  const auto* data = &columns;
+  return frame
+    .Define("module", [data] (ULong64_t row) { return data->module[row]; }, {"rdfentry_"})
+    .Define("lb", [data] (ULong64_t row) { return data->lb[row]; }, {"rdfentry_"})
+    .Define("pile_up", [data] (ULong64_t row) { return data->pile_up[row]; }, {"rdfentry_"})
+    .Define("occupancy", [data] (ULong64_t row) { return data->occupancy[row]; }, {"rdfentry_"})
+    .Define("entries", [data] (ULong64_t row) { return data->entries[row]; }, {"rdfentry_"})
+    .Define("selected", [vetoed_lbs] (int lb, double occupancy, double entries) {
+        return entries > 0. && occupancy != 0. && (!vetoed_lbs || vetoed_lbs->count(lb) == 0);
+      }, {"lb", "occupancy", "entries"})
+    .Define("cell", [&axis, n_columns] (unsigned int module, double pile_up) {
+        return module * n_columns + axis.FindFixBin(pile_up) + 0.5;
+      }, {"module", "pile_up"});
+}
+}  // namespace
+
+struct DataFrameProjection::Frame {
+  Frame(const Columns& columns, double pile_up_min, double pile_up_max, int pile_up_bins,
+        std::shared_ptr<const std::set<int> > vetoed_lbs)
+    : frame(columns.module.size())
+    , axis(pile_up_bins, pile_up_min, pile_up_max)
+    , n_columns(pile_up_bins + 2)
+    , cells(defineColumns(frame, columns, axis, n_columns, std::move(vetoed_lbs)))
+  {
+    // do nothing for now
+  }
+
+  /// The sums and the counts of all cells of one selection.
+  struct Booking {
+    ROOT::RDF::RResultPtr<TH1D> sums;
+    ROOT::RDF::RResultPtr<TH1D> counts;
+  };
+
+  using Cells = decltype(defineColumns(std::declval<ROOT::RDataFrame&>(), std::declval<const Columns&>(),
+                                       std::declval<const TAxis&>(), 0, std::shared_ptr<const std::set<int> >()));
+
+  ROOT::RDataFrame frame;
+  const TAxis axis;
+  const int n_columns;
+  Cells cells;
+  std::vector<Booking> bookings{};
+};
+
+DataFrameProjection::DataFrameProjection(double pile_up_min, double pile_up_max, int pile_up_bins,
+                                         std::shared_ptr<const std::set<int> > vetoed_lbs)
+  : m_pile_up_min(pile_up_min)
+  , m_pile_up_max(pile_up_max)
+  , m_pile_up_bins(pile_up_bins)
+  , m_vetoed_lbs(std::move(vetoed_lbs))
+{
+  // do nothing for now
+}
+
+DataFrameProjection::~DataFrameProjection() = default;
+
+std::size_t DataFrameProjection::addModule(const TProfile& prof, const std::vector<double>& pile_up) {
+  if (m_frame) throw std::invalid_argument("Cannot add modules after booking a projection");
+  const auto module = m_n_modules++;
+  for (std::size_t lb = 1; lb < pile_up.size(); ++lb) {
+    m_columns.module.push_back(module);
+    m_columns.lb.push_back(lb);
+    m_columns.pile_up.push_back(pile_up.at(lb));
+    m_columns.occupancy.push_back(prof.GetBinContent(lb));
+    m_columns.entries.push_back(prof.GetBinEntries(lb));
+  }
+  return module;
+}
+
+std::size_t DataFrameProjection::book(const std::vector<bool>& modules) {
+  if (modules.size() != m_n_modules) throw std::invalid_argument("Selection does not match the number of modules");
+  if (!m_frame) {
+    m_frame = std::make_unique<Frame>(m_columns, m_pile_up_min, m_pile_up_max, m_pile_up_bins, m_vetoed_lbs);
+  }
+
+  // Both actions are only booked here; they are filled together
+  // with those of all other bookings in one event loop.
+  const auto index = m_frame->bookings.size();
+  const int n_cells = m_n_modules * m_frame->n_columns;
+  const auto suffix = "_" + std::to_string(index);
+  auto rows = m_frame->cells.Filter([modules] (unsigned int module, bool selected) {
+      return selected && modules[module];
+    }, {"module", "selected"});
+  auto sums = rows.Histo1D<double, double>({("sums" + suffix).c_str(), "", n_cells, 0., static_cast<double>(n_cells)}, "cell", "occupancy");
+  auto counts = rows.Histo1D<double>({("counts" + suffix).c_str(), "", n_cells, 0., static_cast<double>(n_cells)}, "cell");
+  m_frame->bookings.push_back(Frame::Booking{sums, counts});
+  return index;
+}
+
+std::vector<double> DataFrameProjection::getValues(std::size_t booking) const {
+  if (!m_frame || booking >= m_frame->bookings.size()) throw std::invalid_argument("No such booking");
+  auto& sums = m_frame->bookings.at(booking).sums;
+  auto& counts = m_frame->bookings.at(booking).counts;
+
+  std::vector<double> values;
+  values.reserve(m_n_modules * m_pile_up_bins);
+  for (std::size_t module = 0; module < m_n_modules; ++module) {
+    for (int bin = 1; bin <= m_pile_up_bins; ++bin) {
+      auto cell = module * m_frame->n_columns + bin + 1;
+      auto count = counts->GetBinContent(cell);
+      values.push_back(count > 0 ? sums->GetBinContent(cell) / count : 0.);
+    }
+  }
+  return values;
+}
+
+void DataFrameProjection::run() {
+  // Accessing any result runs the loop for all booked actions.
+  if (!m_frame || m_frame->bookings.empty()) return;
+  m_frame->bookings.front().sums.GetValue();
+}
@@ -2,13 +2,29 @@
 
 #include "TCanvas.h"
 #include "TFile.h"
+#include "TGraphAsymmErrors.h"
 #include "TH1D.h"
 #include "TLegend.h"
 #include "TProfile.h"
 
+#include <algorithm>
+#include <cmath>
 #include <regex>
 #include <iostream>
 #include <iomanip>
+#include <stdexcept>
+
+namespace {
+// The classic style set for stacks of up to seven histograms.
+const std::vector<int> kClassicColors = {1, 1, 1, 2, 2, 4, 4};
+const std::vector<int> kClassicMarkers = {26, 24, 25, 21, 22, 20, 23};
+
+// Colors and markers for larger stacks. Colors cycle fastest, so
+// neighbouring histograms are always distinguishable, and each
+// full color cycle moves on to the next marker.
+const std::vector<int> kAutoColors = {1, 2, 4, 8, 6, 9, 28, 46, 30, 38};
+const std::vector<int> kAutoMarkers = {20, 21, 22, 23, 33, 34, 24, 25, 26, 32, 27, 28};
+}  // namespace
 
 HistStack::HistStack(std::vector<std::unique_ptr<TH1D> >& histos, double x_max) {
   for (auto& hist : histos) {
@@ -16,49 +32,203 @@ HistStack::HistStack(std::vector<std::unique_ptr<TH1D> >& histos, double x_max)
     histograms_.emplace_back(ptr);
   }
 
-  std::vector<int> colors = {1, 1, 1, 2, 2, 4, 4};
-  std::vector<int> markers = {26, 24, 25, 21, 22, 20, 23};
-  int counter{-1};
-
   for (auto& hist : histograms_) {
-    counter++;
     if (hist->GetNbinsX() > 1000) hist->Rebin(50);
     if (x_max != 0) hist->GetXaxis()->SetRangeUser(0, x_max);
-    hist->SetMarkerColor(colors.at(counter));
-    hist->SetLineColor(colors.at(counter));
-    hist->SetMarkerStyle(markers.at(counter));
+    titles_.push_back(hist->GetName());
+
+    for (int i = 1; i < hist->GetNbinsX() + 1; ++i) {
+      max_ = std::max(max_, hist->GetBinContent(i));
+    }
+  }
+
+  this->applyStyles(histograms_.size() <= kClassicColors.size());
+
+  if (!histograms_.empty()) {
+    x_min_ = histograms_.front()->GetXaxis()->GetXmin();
+    x_max_ = histograms_.front()->GetXaxis()->GetXmax();
   }
 }
 
-void HistStack::createLegend(TLegend* legend) {
-  for (const auto& hist : histograms_) {
-    auto name = std::string(hist->GetName());
-    titles_.push_back(name);
-    legend->AddEntry(hist.get(), name.c_str(), "P");
+HistStack::~HistStack() = default;
+
+void HistStack::applyStyles(bool classic) {
+  int counter{-1};
+  for (auto& hist : histograms_) {
+    counter++;
+    int color = classic ? kClassicColors.at(counter) : kAutoColors.at(counter % kAutoColors.size());
+    int marker = classic ? kClassicMarkers.at(counter) : kAutoMarkers.at((counter / kAutoColors.size()) % kAutoMarkers.size());
+    hist->SetMarkerColor(color);
+    hist->SetLineColor(color);
+    hist->SetMarkerStyle(marker);
+  }
+}
+
+void HistStack::autoShift(float total_spread, unsigned int per_page) {
+  if (per_page == 0) per_page = histograms_.size();
+  std::vector<float> shift_values;
+  for (unsigned int i = 0; i < histograms_.size(); ++i) {
+    auto n_on_page = std::min<unsigned int>(per_page, histograms_.size() - (i / per_page) * per_page);
+    if (n_on_page < 2) {
+      shift_values.push_back(0.);
+      continue;
+    }
+    auto position = static_cast<float>(i % per_page) / (n_on_page - 1);
+    shift_values.push_back(total_spread * (position - 0.5));
+  }
+  this->shift(shift_values);
+}
+
+void HistStack::buildFrame() {
+  if (frame_ || histograms_.empty()) return;
+  auto name = std::string(histograms_.front()->GetName()) + "_frame";
+  frame_.reset(static_cast<TH1D*>(histograms_.front()->Clone(name.c_str())));
+  frame_->SetDirectory(nullptr);
+  frame_->Reset("ICES");
+  frame_->GetXaxis()->SetLimits(x_min_, x_max_);
+}
+
+void HistStack::createLegend(TLegend* legend, unsigned int page, unsigned int per_page) {
+  if (per_page == 0) per_page = histograms_.size();
+  auto first = std::min<std::size_t>(page * per_page, histograms_.size());
+  auto last = std::min<std::size_t>(first + per_page, histograms_.size());
+  for (auto i = first; i < last; ++i) {
+    legend->AddEntry(histograms_.at(i).get(), titles_.at(i).c_str(), "P");
   }
 }
 
-void HistStack::draw(TCanvas* canvas) {
+void HistStack::draw(TVirtualPad* pad) {
+  this->drawPage(pad, 0, histograms_.size());
+}
+
+void HistStack::drawEnvelope(TVirtualPad* pad) {
+  if (histograms_.empty()) return;
   if (!has_custom_max_) this->setComfortableMax(this->getMax());
+  this->buildFrame();
+
+  // Collect minimum, maximum and mean of each bin in one pass over
+  // all histograms. Empty bins are not taken into account.
+  const int n_bins = frame_->GetNbinsX();
+  std::vector<double> lows(n_bins, 0.), highs(n_bins, 0.), sums(n_bins, 0.);
+  std::vector<int> counts(n_bins, 0);
   for (const auto& hist : histograms_) {
-    if (hist == histograms_.front()) {
-      hist->Draw("E");
-    } else {
-      hist->Draw("PE SAME");
+    for (int i = 0; i < n_bins; ++i) {
+      auto content = hist->GetBinContent(i + 1);
+      if (content == 0) continue;
+      lows.at(i) = counts.at(i) == 0 ? content : std::min(lows.at(i), content);
+      highs.at(i) = std::max(highs.at(i), content);
+      sums.at(i) += content;
+      counts.at(i)++;
     }
   }
+
+  envelope_ = std::make_unique<TGraphAsymmErrors>();
+  envelope_mean_.reset(static_cast<TH1D*>(frame_->Clone((std::string(frame_->GetName()) + "_mean").c_str())));
+  envelope_mean_->SetDirectory(nullptr);
+  for (int i = 0; i < n_bins; ++i) {
+    if (counts.at(i) == 0) continue;
+    auto mean = sums.at(i) / counts.at(i);
+    auto half_width = frame_->GetBinWidth(i + 1) / 2;
+    auto point = envelope_->GetN();
+    envelope_->SetPoint(point, frame_->GetBinCenter(i + 1), mean);
+    envelope_->SetPointError(point, half_width, half_width, mean - lows.at(i), highs.at(i) - mean);
+    envelope_mean_->SetBinContent(i + 1, mean);
+  }
+  envelope_->SetFillColor(kGray);
+  envelope_->SetLineColor(kGray);
+  envelope_mean_->SetLineColor(kBlack);
+  envelope_mean_->SetLineWidth(2);
+
+  pad->cd();
+  frame_->Draw("AXIS");
+  envelope_->Draw("E2 SAME");
+  envelope_mean_->Draw("HIST SAME");
+  frame_->Draw("AXIS SAME");
+  pad->Modified();
 }
 
-double HistStack::getMax() const {
-  double max{0.};
-  for (const auto& hist : histograms_) {
-    for (unsigned int i = 1; i < hist->GetNbinsX() + 1; ++i) {
-      if (hist->GetBinContent(i) > max) {
-        max = hist->GetBinContent(i);
-      }
+void HistStack::drawRatio(TVirtualPad* pad, unsigned int reference, double min, double max) {
+  if (reference >= histograms_.size()) throw std::invalid_argument("Reference index for ratio out of range");
+  this->buildFrame();
+
+  ratio_frame_.reset(static_cast<TH1D*>(frame_->Clone((std::string(frame_->GetName()) + "_ratio").c_str())));
+  ratio_frame_->SetDirectory(nullptr);
+  ratio_frame_->GetYaxis()->SetRangeUser(min, max);
+  ratio_frame_->GetYaxis()->SetTitle(("Ratio to " + titles_.at(reference)).c_str());
+
+  // The ratios are computed bin by bin, as the histograms may be
+  // shifted and would then fail the consistency checks of Divide().
+  const auto& denominator = histograms_.at(reference);
+  ratios_.clear();
+  for (unsigned int h = 0; h < histograms_.size(); ++h) {
+    if (h == reference) continue;
+    const auto& numerator = histograms_.at(h);
+    auto name = std::string(numerator->GetName()) + "_ratio";
+    ratios_.emplace_back(static_cast<TH1D*>(numerator->Clone(name.c_str())));
+    auto& ratio = ratios_.back();
+    ratio->SetDirectory(nullptr);
+    ratio->Reset("ICES");
+    for (int i = 1; i <= ratio->GetNbinsX(); ++i) {
+      auto num = numerator->GetBinContent(i);
+      auto den = denominator->GetBinContent(i);
+      if (num == 0 || den == 0) continue;
+      auto value = num / den;
+      auto rel_num = numerator->GetBinError(i) / num;
+      auto rel_den = denominator->GetBinError(i) / den;
+      ratio->SetBinContent(i, value);
+      ratio->SetBinError(i, value * std::sqrt(rel_num * rel_num + rel_den * rel_den));
     }
   }
-  return max;
+
+  pad->cd();
+  ratio_frame_->Draw("AXIS");
+  for (const auto& ratio : ratios_) {
+    ratio->Draw("PE SAME");
+  }
+  pad->Modified();
+}
+
+void HistStack::drawPage(TVirtualPad* pad, unsigned int page, unsigned int per_page) {
+  if (histograms_.empty()) return;
+  if (!has_custom_max_) this->setComfortableMax(this->getMax());
+  this->buildFrame();
+
+  // The frame is drawn once, all series of the page are only
+  // added on top of it and the pad is updated just once.
+  if (per_page == 0) per_page = histograms_.size();
+  auto first = std::min<std::size_t>(page * per_page, histograms_.size());
+  auto last = std::min<std::size_t>(first + per_page, histograms_.size());
+  pad->cd();
+  frame_->Draw("AXIS");
+  for (auto i = first; i < last; ++i) {
+    histograms_.at(i)->Draw("PE SAME");
+  }
+  pad->Modified();
+}
+
+void HistStack::drawPaged(TCanvas* canvas, unsigned int per_page, bool legends) {
+  auto n_pages = this->getNPages(per_page);
+  auto n_columns = static_cast<int>(std::ceil(std::sqrt(n_pages)));
+  auto n_rows = static_cast<int>(std::ceil(static_cast<double>(n_pages) / n_columns));
+  canvas->Clear();
+  canvas->Divide(n_columns, n_rows);
+  legends_.clear();
+  for (unsigned int page = 0; page < n_pages; ++page) {
+    auto pad = canvas->cd(page + 1);
+    this->drawPage(pad, page, per_page);
+    if (!legends) continue;
+    legends_.emplace_back(std::make_unique<TLegend>(0.65, 0.6, 0.93, 0.9));
+    legends_.back()->SetTextFont(42);
+    legends_.back()->SetTextSize(0.05);
+    this->createLegend(legends_.back().get(), page, per_page);
+    legends_.back()->Draw();
+  }
+  canvas->cd();
+}
+
+unsigned int HistStack::getNPages(unsigned int per_page) const {
+  if (per_page == 0) return 1;
+  return (histograms_.size() + per_page - 1) / per_page;
 }
 
 std::string HistStack::printTable() const {
@@ -85,6 +255,10 @@ std::string HistStack::printTable() const {
   return print.str();
 }
 
+void HistStack::useAutoStyles() {
+  this->applyStyles(false);
+}
+
 void HistStack::setComfortableMax(double max) {
   has_custom_max_ = true;
   max *= 1.3;
@@ -97,24 +271,28 @@ void HistStack::setComfortableMax(double max) {
   for (auto& hist : histograms_) {
     hist->GetYaxis()->SetRangeUser(0, max);
   }
+  if (frame_) frame_->GetYaxis()->SetRangeUser(0, max);
 }
 
 void HistStack::setXAxisTitle(const std::string& title) {
   for (auto& hist : histograms_) {
     hist->GetXaxis()->SetTitle(title.c_str());
   }
+  if (frame_) frame_->GetXaxis()->SetTitle(title.c_str());
 }
 
 void HistStack::setXAxisTicks(unsigned int ticks) {
   for (auto& hist : histograms_) {
     hist->GetXaxis()->SetNdivisions(ticks, kTRUE);
   }
+  if (frame_) frame_->GetXaxis()->SetNdivisions(ticks, kTRUE);
 }
 
 void HistStack::setYAxisTitle(const std::string& title) {
   for (auto& hist : histograms_) {
     hist->GetYaxis()->SetTitle(title.c_str());
   }
+  if (frame_) frame_->GetYaxis()->SetTitle(title.c_str());
 }
 
 void HistStack::shift(const std::vector<float>& shift_values) {
@@ -122,14 +300,11 @@ void HistStack::shift(const std::vector<float>& shift_values) {
     throw std::invalid_argument("Given shift-value vector must have the same number of entries as histograms");
   }
 
-  auto min = histograms_.at(0)->GetXaxis()->GetXmin();
-  auto max = histograms_.at(0)->GetXaxis()->GetXmax();
   auto width = histograms_.at(0)->GetBinWidth(1);
   int counter{-1};
   for (auto& hist : histograms_) {
     counter++;
     auto shift = shift_values.at(counter) * width;
-    std::cout << "Shifting histogram " << hist->GetName() << " by " << shift << std::endl;
-    hist->GetXaxis()->SetLimits(min + shift, max + shift);
+    hist->GetXaxis()->SetLimits(x_min_ + shift, x_max_ + shift);
   }
 }
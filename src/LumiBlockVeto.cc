@@ -0,0 +1,184 @@
+#include "LumiBlockVeto.h"
+#include "PileUpHistogram.h"
+
+#include "TFile.h"
+#include "TProfile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <utility>
+#include <stdexcept>
+
+namespace {
+// Median of the given values. The vector is reordered.
+double median(std::vector<double>& values) {
+  if (values.empty()) return 0.;
+  auto middle = values.begin() + values.size() / 2;
+  std::nth_element(values.begin(), middle, values.end());
+  return *middle;
+}
+
+// Median absolute deviation, scaled to match the standard
+// deviation for normally distributed values.
+double scaledMad(const std::vector<double>& values, double center) {
+  std::vector<double> deviations;
+  for (const auto& value : values) {
+    deviations.push_back(std::abs(value - center));
+  }
+  return 1.4826 * median(deviations);
+}
+
+// Least-squares fit of a straight line y = a + b*x. Returns the
+// pair (a, b), or (mean of y, 0) if the x values do not vary.
+std::pair<double, double> fitLine(const std::vector<double>& x, const std::vector<double>& y) {
+  if (x.empty()) return {0., 0.};
+  double sum_x{0.}, sum_y{0.}, sum_xx{0.}, sum_xy{0.};
+  for (std::size_t i = 0; i < x.size(); ++i) {
+    sum_x += x[i];
+    sum_y += y[i];
+    sum_xx += x[i] * x[i];
+    sum_xy += x[i] * y[i];
+  }
+  const double n = x.size();
+  const double denominator = n * sum_xx - sum_x * sum_x;
+  if (denominator == 0) return {sum_y / n, 0.};
+  const double slope = (n * sum_xy - sum_x * sum_y) / denominator;
+  return {(sum_y - slope * sum_x) / n, slope};
+}
+
+// Write a set of LBs as a list of contiguous ranges, e.g. "0-245, 310".
+std::string formatRanges(const std::set<int>& lbs) {
+  std::ostringstream ranges;
+  for (auto it = lbs.begin(); it != lbs.end();) {
+    auto first = *it;
+    auto last = first;
+    while (++it != lbs.end() && *it == last + 1) last = *it;
+    if (first != *lbs.begin()) ranges << ", ";
+    ranges << first;
+    if (last != first) ranges << "-" << last;
+  }
+  return ranges.str();
+}
+}  // namespace
+
+LumiBlockVeto::LumiBlockVeto(TFile* file, const std::string& path, const std::set<std::string>& modules,
+                             const std::string& folder) {
+  for (const auto& module : modules) {
+    std::string full_path = path + folder + module;
+    std::unique_ptr<TProfile> prof{dynamic_cast<TProfile*>(file->Get(full_path.c_str()))};
+    if (!prof) throw std::invalid_argument{"Histogram " + full_path + " not found"};
+
+    // The arrays are indexed by LB, which is identical to the bin
+    // number (bin 0 is kept to keep this relation).
+    if (m_n_modules == 0) m_n_lbs = prof->GetNbinsX() + 1;
+    if (static_cast<std::size_t>(prof->GetNbinsX() + 1) != m_n_lbs) {
+      throw std::invalid_argument{"Histogram " + full_path + " has a different number of LBs"};
+    }
+    for (std::size_t lb = 0; lb < m_n_lbs; ++lb) {
+      m_entries.push_back(prof->GetBinEntries(lb));
+      m_occupancies.push_back(prof->GetBinContent(lb));
+    }
+    m_n_modules++;
+  }
+
+  // The pile-up per LB, to remove the pile-up dependence of the
+  // occupancy before looking for anomalous LBs.
+  auto pile_up = PileUpHistogram::readPileUpLookup(file, path);
+  m_pile_up.assign(m_n_lbs, 0.);
+  for (std::size_t lb = 0; lb < m_n_lbs && lb < pile_up->size(); ++lb) {
+    m_pile_up[lb] = pile_up->at(lb);
+  }
+}
+
+std::set<int> LumiBlockVeto::findVetoedLumiBlocks() const {
+  // One pass over all modules, summing up the entries and the
+  // entry-weighted occupancies per LB.
+  std::vector<double> total_entries(m_n_lbs, 0.);
+  std::vector<double> weighted_occupancies(m_n_lbs, 0.);
+  for (std::size_t m = 0; m < m_n_modules; ++m) {
+    const double* entries = m_entries.data() + m * m_n_lbs;
+    const double* occupancies = m_occupancies.data() + m * m_n_lbs;
+    for (std::size_t lb = 0; lb < m_n_lbs; ++lb) {
+      total_entries[lb] += entries[lb];
+      weighted_occupancies[lb] += entries[lb] * occupancies[lb];
+    }
+  }
+
+  // Robust statistics over all LBs with any entries.
+  std::vector<double> active_entries;
+  std::vector<double> mean_occupancies(m_n_lbs, 0.);
+  for (std::size_t lb = 1; lb < m_n_lbs; ++lb) {
+    if (total_entries[lb] <= 0) continue;
+    mean_occupancies[lb] = weighted_occupancies[lb] / total_entries[lb];
+    active_entries.push_back(total_entries[lb]);
+  }
+  const auto n_active = active_entries.size();
+  const auto median_entries = median(active_entries);
+
+  std::set<int> vetoed_lbs{0};
+  std::set<int> inactive_lbs;
+  for (std::size_t lb = 1; lb < m_n_lbs; ++lb) {
+    if (total_entries[lb] < m_min_activity * median_entries || total_entries[lb] <= 0) {
+      inactive_lbs.insert(lb);
+    }
+  }
+
+  // The occupancy rises with the pile-up, which changes over the
+  // fill. The anomaly test is therefore applied to the residuals
+  // of a linear fit of the occupancy vs. pile-up, such that the
+  // LBs at the start and the end of the fill are not vetoed just
+  // for their pile-up. The fit is repeated once without the LBs
+  // that fail the test, to make it robust against those.
+  std::vector<std::size_t> candidates;
+  for (std::size_t lb = 1; lb < m_n_lbs; ++lb) {
+    if (inactive_lbs.count(lb) == 0 && m_pile_up[lb] > 0) candidates.push_back(lb);
+  }
+  std::vector<double> residuals(m_n_lbs, 0.);
+  std::vector<bool> anomalous(m_n_lbs, false);
+  for (int iteration = 0; iteration < 2; ++iteration) {
+    std::vector<double> x, y;
+    for (const auto& lb : candidates) {
+      if (anomalous[lb]) continue;
+      x.push_back(m_pile_up[lb]);
+      y.push_back(mean_occupancies[lb]);
+    }
+    const auto line = fitLine(x, y);
+    std::vector<double> fit_residuals;
+    for (const auto& lb : candidates) {
+      residuals[lb] = mean_occupancies[lb] - line.first - line.second * m_pile_up[lb];
+      if (!anomalous[lb]) fit_residuals.push_back(residuals[lb]);
+    }
+    const auto median_residual = median(fit_residuals);
+    const auto mad_residual = scaledMad(fit_residuals, median_residual);
+    for (const auto& lb : candidates) {
+      anomalous[lb] = mad_residual > 0 && std::abs(residuals[lb] - median_residual) > m_max_deviation * mad_residual;
+    }
+  }
+
+  std::set<int> anomalous_lbs;
+  for (const auto& lb : candidates) {
+    if (anomalous[lb]) anomalous_lbs.insert(lb);
+  }
+  vetoed_lbs.insert(inactive_lbs.begin(), inactive_lbs.end());
+  vetoed_lbs.insert(anomalous_lbs.begin(), anomalous_lbs.end());
+
+  std::cout << "Vetoing " << inactive_lbs.size() << " inactive and " << anomalous_lbs.size();
+  std::cout << " anomalous lumi blocks (" << n_active << " lumi blocks with entries)" << std::endl;
+  std::cout << "  inactive: " << formatRanges(inactive_lbs) << std::endl;
+  std::cout << "  anomalous: " << formatRanges(anomalous_lbs) << std::endl;
+  std::cout << "  vetoed: " << formatRanges(vetoed_lbs) << std::endl;
+  return vetoed_lbs;
+}
+
+void LumiBlockVeto::setMaxDeviation(double n_mad) {
+  if (n_mad <= 0) throw std::invalid_argument("Maximal deviation must be positive");
+  m_max_deviation = n_mad;
+}
+
+void LumiBlockVeto::setMinActivity(double fraction) {
+  if (fraction < 0 || fraction > 1) throw std::invalid_argument("Minimal activity must be within [0, 1]");
+  m_min_activity = fraction;
+}
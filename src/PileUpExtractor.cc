@@ -0,0 +1,241 @@
+#include "PileUpExtractor.h"
+#include "DataFrameProjection.h"
+#include "DirectoryParser.h"
+#include "PileUpHistogram.h"
+
+#include "TAxis.h"
+#include "TFile.h"
+#include "TH1D.h"
+#include "TProfile.h"
+
+#include <cmath>
+#include <regex>
+#include <stdexcept>
+
+int ModuleTable::findBin(double pile_up) const {
+  if (bin_centers.empty()) return -1;
+  TAxis axis{static_cast<int>(bin_centers.size()), pile_up_min, pile_up_max};
+  auto bin = axis.FindFixBin(pile_up);
+  if (bin < 1 || bin > axis.GetNbins()) return -1;
+  return bin - 1;
+}
+
+PileUpExtractor::PileUpExtractor(TFile* file, const std::string& path)
+  : m_file(file)
+  , m_path(path)
+{
+  // do nothing for now
+}
+
+ModuleTable PileUpExtractor::extract(const std::string& wildcard) const {
+  return this->extractMetrics(wildcard, {m_metrics.front()}).front();
+}
+
+std::vector<ModuleTable> PileUpExtractor::extractAll(const std::string& wildcard) const {
+  return this->extractMetrics(wildcard, m_metrics);
+}
+
+std::vector<std::vector<ModuleTable> > PileUpExtractor::extractGroups(const std::vector<ModuleGroup>& groups) const {
+  // Only the modules of any of the groups need to be read.
+  std::string wildcard;
+  for (const auto& group : groups) {
+    wildcard += (wildcard.empty() ? "(" : "|(") + group.wildcard + ")";
+  }
+  if (m_backend == Backend::kDataFrame) return this->extractMetricsDataFrame(wildcard, m_metrics, groups);
+
+  std::vector<std::vector<ModuleTable> > tables;
+  for (const auto& table : this->extractMetrics(wildcard, m_metrics)) {
+    tables.emplace_back();
+    for (const auto& group : groups) {
+      tables.back().push_back(this->filter(table, group.wildcard));
+    }
+  }
+  return tables;
+}
+
+std::vector<ModuleTable> PileUpExtractor::extractMetrics(const std::string& wildcard, const std::vector<std::string>& metrics) const {
+  if (m_backend == Backend::kDataFrame) {
+    std::vector<ModuleTable> tables;
+    for (auto& grouped : this->extractMetricsDataFrame(wildcard, metrics, {ModuleGroup{"", wildcard}})) {
+      tables.push_back(std::move(grouped.front()));
+    }
+    return tables;
+  }
+
+  // The pile-up values are read once and shared by all modules.
+  auto pile_up_lookup = PileUpHistogram::readPileUpLookup(m_file, m_path);
+
+  std::vector<std::set<std::string> > metric_modules;
+  std::set<std::string> all_modules;
+  auto tables = this->setUpTables(wildcard, metrics, metric_modules, all_modules);
+
+  // Read all metrics of one module before moving on to the next.
+  for (const auto& module : all_modules) {
+    for (std::size_t k = 0; k < metrics.size(); ++k) {
+      if (metric_modules.at(k).count(module) == 0) continue;
+      auto& table = tables.at(k);
+      PileUpHistogram hist{m_file, m_path, module, metrics.at(k)};
+      hist.setPileUpLookup(pile_up_lookup);
+      hist.setVetoedLumiBlocks(m_vetoed_lbs);
+      hist.setPileUpRange(m_pile_up_min, m_pile_up_max);
+      hist.fillHisto();
+      if (table.bin_centers.empty()) {
+        for (int i = 1; i <= hist.getHisto()->GetNbinsX(); ++i) {
+          table.bin_centers.push_back(hist.getHisto()->GetBinCenter(i));
+        }
+      }
+      table.modules.push_back(module);
+      for (int i = 1; i <= hist.getHisto()->GetNbinsX(); ++i) {
+        table.values.push_back(hist.getHisto()->GetBinContent(i));
+      }
+    }
+  }
+  return tables;
+}
+
+std::vector<std::vector<ModuleTable> > PileUpExtractor::extractMetricsDataFrame(const std::string& wildcard, const std::vector<std::string>& metrics,
+                                                                                const std::vector<ModuleGroup>& groups) const {
+  auto pile_up_lookup = PileUpHistogram::readPileUpLookup(m_file, m_path);
+
+  std::vector<std::set<std::string> > metric_modules;
+  std::set<std::string> all_modules;
+  auto headers = this->setUpTables(wildcard, metrics, metric_modules, all_modules);
+
+  // Flatten the LB data of all metrics into one dataset, reading
+  // all metrics of one module together.
+  const int n_bins = PileUpHistogram::getPileUpBins(m_pile_up_min, m_pile_up_max);
+  DataFrameProjection projection{m_pile_up_min, m_pile_up_max, n_bins, m_vetoed_lbs};
+  std::vector<std::size_t> metric_of_module;
+  std::vector<std::string> name_of_module;
+  for (const auto& module : all_modules) {
+    for (std::size_t k = 0; k < metrics.size(); ++k) {
+      if (metric_modules.at(k).count(module) == 0) continue;
+      std::string full_path = m_path + metrics.at(k) + module;
+      std::unique_ptr<TProfile> prof{dynamic_cast<TProfile*>(m_file->Get(full_path.c_str()))};
+      if (!prof) throw std::invalid_argument{"Histogram " + full_path + " not found"};
+      projection.addModule(*prof, *pile_up_lookup);
+      metric_of_module.push_back(k);
+      name_of_module.push_back(module);
+    }
+  }
+
+  // Book one projection per group, then fill all of them in a
+  // single event loop.
+  std::vector<std::vector<bool> > selections;
+  for (const auto& group : groups) {
+    const std::regex pattern{group.wildcard};
+    selections.emplace_back();
+    for (const auto& module : name_of_module) {
+      selections.back().push_back(std::regex_search(module, pattern));
+    }
+    projection.book(selections.back());
+  }
+  projection.run();
+
+  // Sort the rows of each group into the tables of the metrics.
+  TAxis axis{n_bins, m_pile_up_min, m_pile_up_max};
+  for (auto& header : headers) {
+    for (int i = 1; i <= n_bins; ++i) {
+      header.bin_centers.push_back(axis.GetBinCenter(i));
+    }
+  }
+  std::vector<std::vector<ModuleTable> > tables(metrics.size());
+  for (std::size_t k = 0; k < metrics.size(); ++k) {
+    tables.at(k).assign(groups.size(), headers.at(k));
+  }
+  for (std::size_t g = 0; g < groups.size(); ++g) {
+    auto values = projection.getValues(g);
+    for (std::size_t m = 0; m < projection.getNModules(); ++m) {
+      if (!selections.at(g).at(m)) continue;
+      auto& table = tables.at(metric_of_module.at(m)).at(g);
+      table.modules.push_back(name_of_module.at(m));
+      auto row = values.begin() + m * n_bins;
+      table.values.insert(table.values.end(), row, row + n_bins);
+    }
+  }
+  return tables;
+}
+
+std::vector<ModuleTable> PileUpExtractor::setUpTables(const std::string& wildcard, const std::vector<std::string>& metrics,
+                                                      std::vector<std::set<std::string> >& metric_modules,
+                                                      std::set<std::string>& all_modules) const {
+  std::vector<ModuleTable> tables(metrics.size());
+  for (std::size_t k = 0; k < metrics.size(); ++k) {
+    DirectoryParser parser{m_file, m_path, wildcard, metrics.at(k)};
+    all_modules.insert(parser.modules.begin(), parser.modules.end());
+    metric_modules.push_back(std::move(parser.modules));
+    tables.at(k).metric = metrics.at(k);
+    tables.at(k).pile_up_min = m_pile_up_min;
+    tables.at(k).pile_up_max = m_pile_up_max;
+  }
+  return tables;
+}
+
+ModuleTable PileUpExtractor::filter(const ModuleTable& table, const std::string& wildcard) const {
+  ModuleTable filtered;
+  filtered.metric = table.metric;
+  filtered.bin_centers = table.bin_centers;
+  filtered.pile_up_min = table.pile_up_min;
+  filtered.pile_up_max = table.pile_up_max;
+  const std::regex pattern{wildcard};
+  const auto n_bins = table.bin_centers.size();
+  for (std::size_t m = 0; m < table.modules.size(); ++m) {
+    if (!std::regex_search(table.modules.at(m), pattern)) continue;
+    filtered.modules.push_back(table.modules.at(m));
+    auto row = table.values.begin() + m * n_bins;
+    filtered.values.insert(filtered.values.end(), row, row + n_bins);
+  }
+  return filtered;
+}
+
+std::vector<double> PileUpExtractor::getModuleValues(const ModuleTable& table, float pile_up) const {
+  std::vector<double> values;
+  auto bin = table.findBin(pile_up);
+  if (bin < 0) return values;
+  for (std::size_t m = 0; m < table.modules.size(); ++m) {
+    auto val = table.at(m, bin);
+    if (val == 0) continue;
+    values.push_back(val);
+  }
+  return values;
+}
+
+std::unique_ptr<TH1D> PileUpExtractor::makeReducedHist(const ModuleTable& table, const std::string& title) const {
+  const int n_bins_from_zero = std::floor((m_pile_up_max + 2.5)/5);
+  TProfile prof{(title).c_str(), ("prof_" + title).c_str(), n_bins_from_zero, -2.5, m_pile_up_max, "s"};
+  for (std::size_t m = 0; m < table.modules.size(); ++m) {
+    for (std::size_t i = 0; i < table.bin_centers.size(); ++i) {
+      if (table.at(m, i) == 0) continue;
+      prof.Fill(table.bin_centers.at(i), table.at(m, i));
+    }
+  }
+  auto projection = std::unique_ptr<TH1D>(prof.ProjectionX());
+  projection->SetName(prof.GetName());
+  projection->SetDirectory(nullptr);
+  projection->GetXaxis()->SetRangeUser(12.5, m_pile_up_max);
+  for (int i = 1; i <= projection->GetNbinsX(); ++i) {
+    projection->SetBinError(i, projection->GetBinError(i) * 3);
+  }
+  return projection;
+}
+
+void PileUpExtractor::setMetrics(const std::vector<std::string>& metrics) {
+  if (metrics.empty()) throw std::invalid_argument("At least one metric is needed");
+  m_metrics.clear();
+  for (auto metric : metrics) {
+    if (metric.empty() || metric.back() != '/') metric += "/";
+    m_metrics.push_back(metric);
+  }
+}
+
+void PileUpExtractor::setPileUpRange(float min, float max) {
+  if (min < 0 || min >= max) throw std::invalid_argument("Check pile-up range for histograms");
+  m_pile_up_min = min;
+  m_pile_up_max = max;
+}
+
+void PileUpExtractor::vetoLumiBlocks(const std::set<int>& lbs) {
+  auto vetoed_lbs = std::make_shared<std::set<int> >(lbs);
+  vetoed_lbs->insert(m_vetoed_lbs->begin(), m_vetoed_lbs->end());
+  m_vetoed_lbs = std::move(vetoed_lbs);
+}
@@ -4,43 +4,49 @@
 #include "TH1D.h"
 #include "TFile.h"
 
+#include <atomic>
 #include <set>
 #include <string>
+#include <vector>
 
-PileUpHistogram::PileUpHistogram(TFile* file, const std::string& path, const std::string& histo_name)
+namespace {
+// Counter to give each temporary profile a unique name. Unlike
+// std::tmpnam(), this is safe when several files are processed
+// in parallel threads.
+std::atomic<unsigned long> g_profile_counter{0};
+}  // namespace
+
+PileUpHistogram::PileUpHistogram(TFile* file, const std::string& path, const std::string& histo_name,
+                                 const std::string& folder)
   : m_file(file)
   , m_path(path)
   , m_histo_name(histo_name)
+  , m_folder(folder)
 {
   // do nothing for now
 }
 
 void PileUpHistogram::fillHisto() {
-  std::string full_path = m_path + "Errors/Modules_BitStr_Occ_Tot/" + m_histo_name;
+  std::string full_path = m_path + m_folder + m_histo_name;
   auto prof = static_cast<TProfile*>(m_file->Get(full_path.c_str()));
   if (!prof) throw std::invalid_argument{"Histogram " + full_path + " not found"};
 
-  // Clean all vetoed luminosity blocks.
-  for (const auto& lb : m_vetoed_lbs) {
-    prof->SetBinContent(lb, 0);
-    prof->SetBinEntries(lb, 0);
-    prof->SetBinError(lb, 0);
-  }
-
   std::unique_ptr<TH1D> hist{static_cast<TH1D*>(prof)};
 
   // Create a profile that we fill with pileup/bandwidth usage pairs
-  auto name = std::string(std::tmpnam(nullptr)) + hist->GetName();
+  auto name = "pu_" + std::to_string(g_profile_counter++) + "_" + hist->GetName();
   auto title_inc_axes = hist->GetTitle() + std::string(";pile-up;bandwidth usage");
   auto tmp_hist = std::make_unique<TProfile>(TProfile{name.c_str(), title_inc_axes.c_str(), m_pile_up_bins, m_pile_up_min, m_pile_up_max, "s"});
   tmp_hist->Approximate(kTRUE);
 
-  // Open the luminosity vs. pileup plot
-  std::unique_ptr<TH1D> pileup{static_cast<TH1D*>(m_file->Get((m_path + "Hits/Interactions_vs_lumi").c_str()))};
-  if (!pileup) throw std::invalid_argument("Pile-up histogram not found");
+  // Get the luminosity vs. pileup relation
+  auto pileup = m_pile_up_lookup ? m_pile_up_lookup : readPileUpLookup(m_file, m_path);
 
-  for (unsigned int i = 1; i < pileup->GetNbinsX() + 1; ++i) {
-    auto pu = pileup->GetBinContent(i);
+  for (unsigned int i = 1; i < pileup->size(); ++i) {
+    // Vetoed luminosity blocks are skipped, the input profile
+    // itself is left untouched.
+    if (m_vetoed_lbs && m_vetoed_lbs->count(i)) continue;
+    auto pu = pileup->at(i);
     auto occ = hist->GetBinContent(i);
     if (occ == 0.) continue;
     tmp_hist->Fill(pu, occ);
@@ -51,16 +57,37 @@ void PileUpHistogram::fillHisto() {
   m_histo->SetName(tmp_hist->GetName());
 }
 
+int PileUpHistogram::getPileUpBins(float min, float max) {
+  return std::floor((max - min)/5);
+}
+
+std::shared_ptr<const std::vector<double> > PileUpHistogram::readPileUpLookup(TFile* file, const std::string& path) {
+  std::unique_ptr<TH1D> pileup{static_cast<TH1D*>(file->Get((path + "Hits/Interactions_vs_lumi").c_str()))};
+  if (!pileup) throw std::invalid_argument("Pile-up histogram not found");
+  auto lookup = std::make_shared<std::vector<double> >();
+  for (int i = 0; i < pileup->GetNbinsX() + 1; ++i) {
+    lookup->push_back(pileup->GetBinContent(i));
+  }
+  return lookup;
+}
+
+void PileUpHistogram::setPileUpLookup(std::shared_ptr<const std::vector<double> > lookup) {
+  m_pile_up_lookup = std::move(lookup);
+}
+
 void PileUpHistogram::setPileUpRange(float min, float max) {
   if (min < 0 || min >= max) throw std::invalid_argument("Check pile-up range for histograms");
-  int n_bins = std::floor((max - min)/5);
   m_pile_up_min = min;
   m_pile_up_max = max;
-  m_pile_up_bins = n_bins;
+  m_pile_up_bins = getPileUpBins(min, max);
+}
+
+void PileUpHistogram::setVetoedLumiBlocks(std::shared_ptr<const std::set<int> > lbs) {
+  m_vetoed_lbs = std::move(lbs);
 }
 
 void PileUpHistogram::vetoLumiBlocks(const std::set<int> lbs) {
-  for (const auto& lb : lbs) {
-    m_vetoed_lbs.insert(lb);
-  }
+  auto vetoed_lbs = std::make_shared<std::set<int> >(lbs);
+  if (m_vetoed_lbs) vetoed_lbs->insert(m_vetoed_lbs->begin(), m_vetoed_lbs->end());
+  m_vetoed_lbs = std::move(vetoed_lbs);
 }
@@ -0,0 +1,13 @@
+#include "PixelModules.h"
+
+const std::string kDefaultMetric = "Errors/Modules_BitStr_Occ_Tot/";
+
+const std::vector<ModuleGroup> kPixelModuleGroups = {
+  {"L0", "^L0"},
+  {"L1", "^L1"},
+  {"L2", "^L2"},
+  {"ECA", "^ECA"},
+  {"ECC", "^ECC((?!S1_M[16]).)*$"},
+  {"IBL2D", "^LI.*_[AC][^(7|8)]_"},
+  {"IBL3D", "^LI.*_[AC][78]_"},
+};
@@ -0,0 +1,286 @@
+#include "RunIndex.h"
+
+#include "TFile.h"
+#include "TH1.h"
+#include "TKey.h"
+#include "TSystem.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <regex>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+std::string absolutePath(const std::string& file) {
+  char resolved[PATH_MAX];
+  if (!realpath(file.c_str(), resolved)) return file;
+  return std::string(resolved);
+}
+
+bool isMonitoringFile(const std::string& name) {
+  return std::regex_search(name, std::regex("HIST|\\.root(\\.[0-9]+)?$"));
+}
+
+std::string streamFromName(const std::string& file) {
+  std::string name = gSystem->BaseName(file.c_str());
+  std::smatch match;
+  if (std::regex_search(name, match, std::regex("(express_express|physics_[A-Za-z]+|calibration_[A-Za-z]+)"))) {
+    return match[1];
+  }
+
+  // Fall back to the abbreviations used for local copies.
+  if (name.find("express") != std::string::npos) return "express_express";
+  if (name.find("zerobias") != std::string::npos) return "physics_ZeroBias";
+  if (name.find("enhanced") != std::string::npos) return "physics_EnhancedBias";
+  return "???";
+}
+}  // namespace
+
+RunIndex::RunIndex(const std::string& index_file)
+  : m_index_file(index_file)
+{
+  std::ifstream input{index_file};
+  std::string line;
+  while (std::getline(input, line)) {
+    if (line.empty() || line.front() == '#') continue;
+    std::istringstream fields{line};
+    Entry entry;
+    std::getline(fields, entry.file, '\t');
+    fields >> entry.modified >> entry.size >> entry.run >> entry.stream >> entry.fill >> entry.lb_min >> entry.lb_max;
+    if (fields.fail()) {
+      std::cerr << "Skipping malformed line in " << index_file << ": " << line << std::endl;
+      continue;
+    }
+    this->insert(entry);
+  }
+}
+
+const RunIndex::Entry* RunIndex::find(const std::string& file) const {
+  auto entry = m_entries.find(absolutePath(file));
+  if (entry == m_entries.end()) return nullptr;
+  return &entry->second;
+}
+
+std::vector<const RunIndex::Entry*> RunIndex::findRun(int run) const {
+  std::vector<const Entry*> entries;
+  auto files = m_runs.find(run);
+  if (files == m_runs.end()) return entries;
+  for (const auto& file : files->second) {
+    entries.push_back(&m_entries.at(file));
+  }
+  return entries;
+}
+
+void RunIndex::insert(Entry entry) {
+  // If the fill table does not know the run, keep the fill that
+  // is already indexed for it (e.g. when a file is rescanned).
+  auto fill = m_fills.find(entry.run);
+  if (fill != m_fills.end()) {
+    entry.fill = fill->second;
+  } else if (entry.fill == "???" && m_runs.count(entry.run)) {
+    for (const auto& file : m_runs.at(entry.run)) {
+      if (m_entries.at(file).fill == "???") continue;
+      entry.fill = m_entries.at(file).fill;
+      break;
+    }
+  }
+
+  this->remove(entry.file);
+  m_runs[entry.run].insert(entry.file);
+  m_entries[entry.file] = std::move(entry);
+}
+
+void RunIndex::loadFillTable(const std::string& path) {
+  std::ifstream input{path};
+  if (!input) throw std::invalid_argument{"Fill table " + path + " not found"};
+  std::string line;
+  while (std::getline(input, line)) {
+    if (line.empty() || line.front() == '#') continue;
+    std::istringstream fields{line};
+    int run{0};
+    std::string fill;
+    if (!(fields >> run >> fill)) {
+      std::cerr << "Skipping malformed line in " << path << ": " << line << std::endl;
+      continue;
+    }
+    m_fills[run] = fill;
+  }
+
+  // Update the fill numbers of the runs indexed so far.
+  for (auto& pair : m_entries) {
+    auto known = m_fills.find(pair.second.run);
+    if (known == m_fills.end() || known->second == pair.second.fill) continue;
+    pair.second.fill = known->second;
+    m_modified = true;
+  }
+}
+
+void RunIndex::remove(const std::string& file) {
+  auto entry = m_entries.find(file);
+  if (entry == m_entries.end()) return;
+  auto files = m_runs.find(entry->second.run);
+  if (files != m_runs.end()) {
+    files->second.erase(file);
+    if (files->second.empty()) m_runs.erase(files);
+  }
+  m_entries.erase(entry);
+}
+
+void RunIndex::save() {
+  if (!m_modified) return;
+
+  // Write to a temporary file first and then move it into place,
+  // such that concurrent jobs never read a half-written index.
+  const auto temp_file = m_index_file + ".tmp." + std::to_string(gSystem->GetPid());
+  std::ofstream output{temp_file};
+  if (!output) throw std::invalid_argument{"Cannot write index file " + temp_file};
+  output << "# file\tmodified\tsize\trun\tstream\tfill\tlb_min\tlb_max" << std::endl;
+
+  // Write the files in sorted order to keep the index readable.
+  std::set<std::string> files;
+  for (const auto& pair : m_entries) files.insert(pair.first);
+  for (const auto& file : files) {
+    const auto& entry = m_entries.at(file);
+    output << entry.file << "\t" << entry.modified << "\t" << entry.size << "\t";
+    output << entry.run << "\t" << entry.stream << "\t" << entry.fill << "\t";
+    output << entry.lb_min << "\t" << entry.lb_max << std::endl;
+  }
+  output.close();
+  if (!output || std::rename(temp_file.c_str(), m_index_file.c_str()) != 0) {
+    std::remove(temp_file.c_str());
+    throw std::invalid_argument{"Cannot write index file " + m_index_file};
+  }
+  m_modified = false;
+}
+
+RunIndex::Entry RunIndex::scanFile(const std::string& file, long modified, long long size) const {
+  std::cout << "Indexing file " << file << std::endl;
+  Entry entry;
+  entry.file = file;
+  entry.modified = modified;
+  entry.size = size;
+  entry.stream = streamFromName(file);
+
+  std::unique_ptr<TFile> tfile{TFile::Open(file.c_str(), "READ")};
+  if (!tfile || tfile->IsZombie()) {
+    std::cerr << "Could not open file " << file << std::endl;
+    return entry;
+  }
+
+  // Only the top-level keys are needed to find the run.
+  TIter nextkey(tfile->GetListOfKeys());
+  TKey *key = nullptr;
+  const std::regex run_pattern{"^run_([0-9]+)$"};
+  while ((key = static_cast<TKey*>(nextkey()))) {
+    std::string name = key->GetName();
+    std::smatch match;
+    if (!std::regex_match(name, match, run_pattern)) continue;
+    if (entry.run != 0) {
+      std::cerr << "File " << file << " holds more than one run, only indexing run " << entry.run << std::endl;
+      break;
+    }
+    entry.run = std::stoi(match[1]);
+  }
+  if (entry.run == 0) {
+    std::cerr << "No run found in file " << file << std::endl;
+    return entry;
+  }
+
+  // The LB range is given by all LBs with a recorded pile-up value.
+  auto path = "run_" + std::to_string(entry.run) + "/Pixel/Hits/Interactions_vs_lumi";
+  auto pileup = dynamic_cast<TH1*>(tfile->Get(path.c_str()));
+  if (!pileup) return entry;
+  for (int i = 1; i < pileup->GetNbinsX() + 1; ++i) {
+    if (pileup->GetBinContent(i) <= 0) continue;
+    if (entry.lb_min == 0) entry.lb_min = i;
+    entry.lb_max = i;
+  }
+  return entry;
+}
+
+unsigned int RunIndex::update(const std::string& directory) {
+  const auto top = absolutePath(directory);
+  std::set<std::string> found;
+  std::vector<std::string> unreadable;
+  unsigned int n_scanned{0};
+
+  // Without the top directory (e.g. a missing mount), nothing can
+  // be said about the indexed files, so stop before pruning.
+  FileStat_t top_stat;
+  if (gSystem->GetPathInfo(top.c_str(), top_stat) != 0 || !R_ISDIR(top_stat.fMode)) {
+    throw std::invalid_argument{"Could not open directory " + directory};
+  }
+
+  std::vector<std::string> directories{top};
+  while (!directories.empty()) {
+    auto dir = directories.back();
+    directories.pop_back();
+    auto dirp = gSystem->OpenDirectory(dir.c_str());
+    if (!dirp) {
+      if (dir == top) throw std::invalid_argument{"Could not open directory " + directory};
+      std::cerr << "Could not open directory " << dir << std::endl;
+      unreadable.push_back(dir + "/");
+      continue;
+    }
+
+    const char* name = nullptr;
+    while ((name = gSystem->GetDirEntry(dirp))) {
+      std::string entry_name{name};
+      if (entry_name == "." || entry_name == "..") continue;
+      auto path = dir + "/" + entry_name;
+      FileStat_t stat;
+      if (gSystem->GetPathInfo(path.c_str(), stat) != 0) continue;
+      if (R_ISDIR(stat.fMode)) {
+        directories.push_back(path);
+        continue;
+      }
+      if (!isMonitoringFile(entry_name)) continue;
+      found.insert(path);
+
+      // Files that did not change since the last scan are skipped.
+      auto entry = m_entries.find(path);
+      if (entry != m_entries.end() && entry->second.modified == stat.fMtime && entry->second.size == stat.fSize) continue;
+      this->insert(this->scanFile(path, stat.fMtime, stat.fSize));
+      m_modified = true;
+      n_scanned++;
+    }
+    gSystem->FreeDirectory(dirp);
+  }
+
+  // Drop all files below this directory that do not exist anymore.
+  // Files in subdirectories that could not be read are kept.
+  auto has_prefix = [] (const std::string& file, const std::string& prefix) {
+    return file.compare(0, prefix.size(), prefix) == 0;
+  };
+  std::vector<std::string> vanished;
+  for (const auto& pair : m_entries) {
+    if (!has_prefix(pair.first, top + "/")) continue;
+    if (found.count(pair.first) != 0) continue;
+    if (std::any_of(unreadable.begin(), unreadable.end(), [&] (const std::string& dir) { return has_prefix(pair.first, dir); })) continue;
+    vanished.push_back(pair.first);
+  }
+  for (const auto& file : vanished) {
+    this->remove(file);
+    m_modified = true;
+  }
+
+  return n_scanned;
+}
+
+const RunIndex::Entry& RunIndex::updateFile(const std::string& file) {
+  const auto path = absolutePath(file);
+  FileStat_t stat;
+  if (gSystem->GetPathInfo(path.c_str(), stat) != 0) throw std::invalid_argument{"File " + file + " not found"};
+  auto entry = m_entries.find(path);
+  if (entry == m_entries.end() || entry->second.modified != stat.fMtime || entry->second.size != stat.fSize) {
+    this->insert(this->scanFile(path, stat.fMtime, stat.fSize));
+    m_modified = true;
+  }
+  return m_entries.at(path);
+}
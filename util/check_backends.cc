@@ -0,0 +1,100 @@
+#include "DirectoryParser.h"
+#include "LumiBlockVeto.h"
+#include "PileUpExtractor.h"
+
+#include "TROOT.h"
+#include "TH1D.h"
+#include "TFile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <memory>
+
+namespace {
+// Values are equal if they agree up to the summation order.
+const double kTolerance = 1e-9;
+
+double deviation(double a, double b) {
+  return std::abs(a - b) / std::max({std::abs(a), std::abs(b), 1e-12});
+}
+}  // namespace
+
+
+
+int main(int argc, char** argv) {
+  // Sanitize the user input.
+  // ---------------------------------------------------------
+  if (argc < 3) {
+    std::cerr << "Wrong number of positional arguments" << std::endl;
+    std::cerr << "Usage: ./check_backends [input file] [run number] [additional metric folders (optional)] ..." << std::endl;
+    return -1;
+  }
+
+  auto file = TFile::Open(argv[1], "READ");
+  if (!file) return -1;
+  std::string path = "run_" + std::string(argv[2]) + "/Pixel/";
+  if (!file->GetDirectory(path.c_str())) {
+    std::cerr << "Directory " + path + " does not exist. Check run number" << std::endl;
+    return -1;
+  }
+
+  // Set up the extraction exactly as in plot.
+  // ---------------------------------------------------------
+  DirectoryParser all_modules{file, path};
+  LumiBlockVeto veto{file, path, all_modules.modules};
+  PileUpExtractor extractor{file, path};
+  extractor.vetoLumiBlocks(veto.findVetoedLumiBlocks());
+  extractor.setPileUpRange(22.5, 57.5);
+  std::vector<std::string> metrics{kDefaultMetric};
+  for (int i = 3; i < argc; ++i) {
+    metrics.push_back(argv[i]);
+  }
+  extractor.setMetrics(metrics);
+
+  // Run both backends on all module groups.
+  // ---------------------------------------------------------
+  std::cout << "Extracting with the key-walk backend" << std::endl;
+  extractor.setBackend(PileUpExtractor::Backend::kKeyWalk);
+  const auto key_walk = extractor.extractGroups(kPixelModuleGroups);
+
+  std::cout << "Extracting with the RDataFrame backend" << std::endl;
+  ROOT::EnableImplicitMT();
+  extractor.setBackend(PileUpExtractor::Backend::kDataFrame);
+  const auto data_frame = extractor.extractGroups(kPixelModuleGroups);
+
+  // Compare the modules and values of all tables as well as the
+  // reduced histograms made from them.
+  // ---------------------------------------------------------
+  bool success{true};
+  for (std::size_t k = 0; k < key_walk.size(); ++k) {
+    for (std::size_t g = 0; g < kPixelModuleGroups.size(); ++g) {
+      const auto& title = kPixelModuleGroups.at(g).title;
+      const auto& lhs = key_walk.at(k).at(g);
+      const auto& rhs = data_frame.at(k).at(g);
+      std::cout << extractor.getMetrics().at(k) << " " << title << ": ";
+      if (lhs.modules != rhs.modules || lhs.values.size() != rhs.values.size()) {
+        std::cout << "MISMATCH (modules differ: " << lhs.getNModules() << " vs. " << rhs.getNModules() << ")" << std::endl;
+        success = false;
+        continue;
+      }
+
+      double max_deviation{0.};
+      for (std::size_t i = 0; i < lhs.values.size(); ++i) {
+        max_deviation = std::max(max_deviation, deviation(lhs.values.at(i), rhs.values.at(i)));
+      }
+      auto lhs_hist = extractor.makeReducedHist(lhs, title + "_key_walk");
+      auto rhs_hist = extractor.makeReducedHist(rhs, title + "_data_frame");
+      for (int i = 0; i <= lhs_hist->GetNbinsX() + 1; ++i) {
+        max_deviation = std::max(max_deviation, deviation(lhs_hist->GetBinContent(i), rhs_hist->GetBinContent(i)));
+      }
+
+      const bool agree = max_deviation < kTolerance;
+      std::cout << (agree ? "OK" : "MISMATCH") << " (" << lhs.getNModules() << " modules, ";
+      std::cout << "max. relative deviation " << max_deviation << ")" << std::endl;
+      if (!agree) success = false;
+    }
+  }
+
+  return success ? 0 : 1;
+}
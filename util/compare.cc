@@ -0,0 +1,277 @@
+#include "HistStack.h"
+#include "DirectoryParser.h"
+#include "LumiBlockVeto.h"
+#include "PileUpExtractor.h"
+#include "RunIndex.h"
+#include "AtlasStyle.h"
+#include "AtlasLabels.h"
+
+#include "TROOT.h"
+#include "TLatex.h"
+#include "TH1D.h"
+#include "TFile.h"
+#include "TLegend.h"
+#include "TCanvas.h"
+#include "TPad.h"
+
+#include <algorithm>
+#include <exception>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+void SupportLabel(double xpos, double ypos, const std::string& text) {
+  TLatex p;
+  p.SetNDC();
+  p.SetTextFont(42);
+  p.DrawLatex(xpos, ypos, text.c_str());
+}
+
+// Wait for all threads and collect their results. Exceptions of
+// the threads are rethrown by get(); these are printed and false
+// is returned once all threads have finished.
+template <typename T>
+bool collect(std::vector<std::future<T> >& futures, std::vector<T>& results) {
+  bool success{true};
+  for (auto& future : futures) {
+    try {
+      results.emplace_back(future.get());
+    } catch (const std::exception& e) {
+      std::cerr << e.what() << std::endl;
+      success = false;
+    }
+  }
+  return success;
+}
+
+// Marker for modules that do not exist in one of the streams.
+const std::size_t kMissing = static_cast<std::size_t>(-1);
+
+// All results extracted from one stream file.
+struct StreamResult {
+  std::string label{"???"};
+  std::vector<std::unique_ptr<TH1D> > groups{};
+  ModuleTable modules{};
+};
+}  // namespace
+
+
+
+int main(int argc, char** argv) {
+  SetAtlasStyle();
+
+  // Sanitize the user input.
+  // ---------------------------------------------------------
+  if (argc < 4) {
+    std::cerr << "Wrong number of positional arguments" << std::endl;
+    std::cerr << "Usage: ./compare [run number] [input file 1] [input file 2] ..." << std::endl;
+    return -1;
+  }
+  std::string path = "run_" + std::string(argv[1]) + "/Pixel/";
+  std::vector<std::string> files{argv + 2, argv + argc};
+
+  // Look up the streams (and the fill) of all files.
+  // ---------------------------------------------------------
+  // The index only provides the labels, so any problem with it
+  // (e.g. a missing fill table) is not fatal.
+  std::string fill_number = "???";
+  std::vector<std::string> streams(files.size(), "???");
+  try {
+    RunIndex index{"output/run_index.txt"};
+    index.loadFillTable("data/fills.txt");
+    for (std::size_t i = 0; i < files.size(); ++i) {
+      const auto& entry = index.updateFile(files.at(i));
+      if (entry.run != std::stoi(argv[1])) {
+        std::cerr << "Warning: file " << files.at(i) << " is indexed with run " << entry.run << std::endl;
+      }
+      fill_number = entry.fill;
+      streams.at(i) = entry.stream;
+    }
+    index.save();
+  } catch (const std::exception& e) {
+    std::cerr << "Warning: " << e.what() << ", fill and streams may be unknown" << std::endl;
+  }
+
+  // Label each file by its stream. Streams that appear more than
+  // once (or are unknown) get the file index appended, such that
+  // all histograms and table columns can be told apart.
+  std::vector<std::string> labels;
+  for (std::size_t i = 0; i < streams.size(); ++i) {
+    const auto& stream = streams.at(i);
+    if (stream != "???" && std::count(streams.begin(), streams.end(), stream) == 1) {
+      labels.push_back(stream);
+    } else {
+      labels.push_back(stream + "_" + std::to_string(i + 1));
+    }
+  }
+
+  const double pile_up_min = 22.5;
+  const double pile_up_max = 57.5;
+
+  // Both steps below run all streams in parallel, with each
+  // thread opening its own file. Histograms must not be attached
+  // to any directory, as those are shared between the threads.
+  // ---------------------------------------------------------
+  ROOT::EnableThreadSafety();
+  TH1::AddDirectory(kFALSE);
+  auto open_file = [&] (const std::string& file_name) {
+    std::unique_ptr<TFile> file{TFile::Open(file_name.c_str(), "READ")};
+    if (!file || !file->GetDirectory(path.c_str())) {
+      throw std::invalid_argument{"Directory " + path + " does not exist in " + file_name};
+    }
+    return file;
+  };
+
+  // First determine the vetoed lumi blocks of each stream. All
+  // streams are then compared on the same set of LBs, i.e. the
+  // union of all vetoes is applied to every stream.
+  // ---------------------------------------------------------
+  auto find_veto = [&] (const std::string& file_name) {
+    auto file = open_file(file_name);
+    DirectoryParser all_modules{file.get(), path};
+    LumiBlockVeto veto{file.get(), path, all_modules.modules};
+    return veto.findVetoedLumiBlocks();
+  };
+
+  std::vector<std::future<std::set<int> > > veto_futures;
+  for (const auto& file : files) {
+    veto_futures.emplace_back(std::async(std::launch::async, find_veto, file));
+  }
+  std::vector<std::set<int> > vetoes;
+  if (!collect(veto_futures, vetoes)) return -1;
+
+  std::set<int> vetoed_lbs;
+  for (std::size_t i = 0; i < vetoes.size(); ++i) {
+    std::cout << "Stream " << labels.at(i) << " vetoes " << vetoes.at(i).size() << " lumi blocks" << std::endl;
+    vetoed_lbs.insert(vetoes.at(i).begin(), vetoes.at(i).end());
+  }
+  std::cout << "Vetoing " << vetoed_lbs.size() << " lumi blocks in all streams" << std::endl;
+
+  // Then extract all modules of each stream once and reduce them
+  // to one histogram per group.
+  // ---------------------------------------------------------
+  auto extract_stream = [&] (const std::string& file_name, const std::string& label) {
+    StreamResult result;
+    result.label = label;
+    auto file = open_file(file_name);
+    PileUpExtractor extractor{file.get(), path};
+    extractor.vetoLumiBlocks(vetoed_lbs);
+    extractor.setPileUpRange(pile_up_min, pile_up_max);
+    result.modules = extractor.extract("");
+    for (const auto& group : kPixelModuleGroups) {
+      auto hist = extractor.makeReducedHist(extractor.filter(result.modules, group.wildcard), group.title + "_" + label);
+      result.groups.emplace_back(std::move(hist));
+    }
+    return result;
+  };
+
+  std::vector<std::future<StreamResult> > futures;
+  for (std::size_t i = 0; i < files.size(); ++i) {
+    std::cout << "Extracting stream " << labels.at(i) << " from file " << files.at(i) << std::endl;
+    futures.emplace_back(std::async(std::launch::async, extract_stream, files.at(i), labels.at(i)));
+  }
+  std::vector<StreamResult> results;
+  if (!collect(futures, results)) return -1;
+
+  // Draw one plot per group with all streams and a ratio panel
+  // with respect to the first stream.
+  // -------------------------------------------------------
+  TCanvas canvas{"canvas", "canvas", 800, 800};
+  for (std::size_t g = 0; g < kPixelModuleGroups.size(); ++g) {
+    const auto& title = kPixelModuleGroups.at(g).title;
+    std::vector<std::unique_ptr<TH1D> > hists;
+    for (auto& result : results) {
+      hists.emplace_back(std::move(result.groups.at(g)));
+      hists.back()->SetName(result.label.c_str());
+    }
+
+    canvas.Clear();
+    TPad top{"top", "top", 0., 0.3, 1., 1.};
+    TPad bottom{"bottom", "bottom", 0., 0., 1., 0.3};
+    top.SetBottomMargin(0.02);
+    bottom.SetTopMargin(0.02);
+    bottom.SetBottomMargin(0.35);
+    top.Draw();
+    bottom.Draw();
+
+    HistStack stack{hists};
+    stack.useAutoStyles();
+    stack.setXAxisTitle("Average #mu per lumi block");
+    stack.setYAxisTitle("Average bandwidth usage");
+    stack.setComfortableMax(stack.getMax());
+    stack.setXAxisTicks(210);
+    stack.autoShift(0.32);
+    TLegend legend{0.55, 0.05, 0.9, 0.3};
+    legend.SetTextFont(42);
+    legend.SetTextSize(0.04);
+    stack.createLegend(&legend);
+    stack.draw(&top);
+    legend.Draw("SAME");
+    ATLASLabel(0.2, 0.88, "Pixel Internal");
+    SupportLabel(0.2, 0.82, "Fill " + fill_number + ", " + title);
+    stack.drawRatio(&bottom);
+
+    canvas.SaveAs(("output/compare_streams_" + title + ".pdf").c_str());
+    canvas.SaveAs(("output/compare_streams_" + title + ".png").c_str());
+    std::cout << title << std::endl << stack.printTable() << std::endl;
+  }
+
+  // Per-module difference table: the values of all streams per
+  // module and pile-up bin, together with their difference to
+  // the first stream.
+  // -------------------------------------------------------
+  std::map<std::string, std::vector<std::size_t> > rows;
+  for (std::size_t s = 0; s < results.size(); ++s) {
+    const auto& modules = results.at(s).modules.modules;
+    for (std::size_t m = 0; m < modules.size(); ++m) {
+      auto& row = rows[modules.at(m)];
+      row.resize(results.size(), kMissing);
+      row.at(s) = m;
+    }
+  }
+
+  std::ofstream table{"output/stream_comparison.txt"};
+  table << "Module\tPile-Up";
+  for (const auto& result : results) table << "\t" << result.label;
+  for (std::size_t s = 1; s < results.size(); ++s) table << "\t" << results.at(s).label << " - " << results.front().label;
+  table << std::endl;
+
+  const auto& bin_centers = results.front().modules.bin_centers;
+  for (const auto& row : rows) {
+    for (std::size_t i = 0; i < bin_centers.size(); ++i) {
+      std::vector<double> values;
+      bool has_value{false};
+      for (std::size_t s = 0; s < results.size(); ++s) {
+        const auto& modules = results.at(s).modules;
+        auto m = row.second.at(s);
+        values.push_back(m != kMissing ? modules.at(m, i) : 0.);
+        if (values.back() != 0) has_value = true;
+      }
+      if (!has_value) continue;
+
+      // Modules missing in a stream are written as "-", and their
+      // differences are left empty, to tell them from a zero.
+      const auto& present = row.second;
+      table << row.first << "\t" << bin_centers.at(i);
+      for (std::size_t s = 0; s < values.size(); ++s) {
+        table << "\t";
+        if (present.at(s) != kMissing) table << values.at(s);
+        else table << "-";
+      }
+      for (std::size_t s = 1; s < values.size(); ++s) {
+        table << "\t";
+        if (present.at(s) != kMissing && present.front() != kMissing) table << values.at(s) - values.front();
+      }
+      table << std::endl;
+    }
+  }
+  table.close();
+
+  return 0;
+}
@@ -0,0 +1,55 @@
+#include "RunIndex.h"
+
+#include <exception>
+#include <iostream>
+#include <string>
+
+int main(int argc, char** argv) {
+  // Sanitize the user input.
+  // ---------------------------------------------------------
+  // With "--run", the index is only queried for the files that
+  // hold the given run, which are listed one per line as
+  // (file, stream, fill, first LB, last LB).
+  if (argc > 1 && std::string(argv[1]) == "--run") {
+    if (argc < 3 || argc > 4) {
+      std::cerr << "Wrong number of positional arguments" << std::endl;
+      std::cerr << "Usage: ./index --run [run number] [index file (optional)]" << std::endl;
+      return -1;
+    }
+    RunIndex index{argc > 3 ? argv[3] : "output/run_index.txt"};
+    const auto entries = index.findRun(std::stoi(argv[2]));
+    if (entries.empty()) {
+      std::cerr << "No files indexed for run " << argv[2] << std::endl;
+      return -1;
+    }
+    for (const auto& entry : entries) {
+      std::cout << entry->file << "\t" << entry->stream << "\t" << entry->fill << "\t";
+      std::cout << entry->lb_min << "\t" << entry->lb_max << std::endl;
+    }
+    return 0;
+  }
+
+  if (argc < 2 || argc > 4) {
+    std::cerr << "Wrong number of positional arguments" << std::endl;
+    std::cerr << "Usage: ./index [directory] [index file (optional)] [fill table (optional)]" << std::endl;
+    std::cerr << "       ./index --run [run number] [index file (optional)]" << std::endl;
+    return -1;
+  }
+  std::string index_file = argc > 2 ? argv[2] : "output/run_index.txt";
+  std::string fill_table = argc > 3 ? argv[3] : "data/fills.txt";
+
+  // Update the index with all new or modified files.
+  // ---------------------------------------------------------
+  RunIndex index{index_file};
+  try {
+    index.loadFillTable(fill_table);
+    auto n_scanned = index.update(argv[1]);
+    index.save();
+    std::cout << "Scanned " << n_scanned << " new or modified files, index is " << index_file << std::endl;
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return -1;
+  }
+
+  return 0;
+}
@@ -1,9 +1,12 @@
 #include "HistStack.h"
-#include "PileUpHistogram.h"
 #include "DirectoryParser.h"
+#include "LumiBlockVeto.h"
+#include "PileUpExtractor.h"
+#include "RunIndex.h"
 #include "AtlasStyle.h"
 #include "AtlasLabels.h"
 
+#include "TROOT.h"
 #include "TLatex.h"
 #include "TProfile.h"
 #include "TH1D.h"
@@ -11,8 +14,11 @@
 #include "TLegend.h"
 #include "TCanvas.h"
 
+#include <algorithm>
+#include <exception>
 #include <fstream>
 #include <iostream>
+#include <map>
 #include <memory>
 
 namespace {
@@ -31,30 +37,50 @@ int main(int argc, char** argv) {
 
   // Sanitize the user input.
   // ---------------------------------------------------------
-  if (argc != 3) {
+  // The only option, "--dataframe", selects the RDataFrame-based
+  // extraction backend; all other arguments are positional.
+  std::vector<std::string> args;
+  auto backend = PileUpExtractor::Backend::kKeyWalk;
+  for (int i = 1; i < argc; ++i) {
+    if (std::string(argv[i]) == "--dataframe") {
+      backend = PileUpExtractor::Backend::kDataFrame;
+      continue;
+    }
+    args.push_back(argv[i]);
+  }
+  if (args.size() < 2) {
     std::cerr << "Wrong number of positional arguments" << std::endl;
-    std::cerr << "Usage: ./plot [input file] [run number]" << std::endl;
+    std::cerr << "Usage: ./plot [--dataframe] [input file] [run number] [additional metric folders (optional)] ..." << std::endl;
     return -1;
   }
 
-  auto file = TFile::Open(argv[1], "READ");
+  auto file = TFile::Open(args.at(0).c_str(), "READ");
   if (!file) return -1;
-  std::string path = "run_" + std::string(argv[2]) + "/Pixel/";
+  std::string path = "run_" + args.at(1) + "/Pixel/";
   if (!file->GetDirectory(path.c_str())) {
     std::cerr << "Directory " + path + " does not exist. Check run number" << std::endl;
     return -1;
   }
 
-  // Extract infos like run number and stream.
+  // Extract infos like fill number and stream from the index.
   // ---------------------------------------------------------
+  // The index only provides the labels, so any problem with it
+  // (e.g. a missing fill table) is not fatal.
   std::string fill_number = "???";
-  if (std::string(argv[1]).find("339849") != std::string::npos) fill_number = "6358";
-  if (std::string(argv[1]).find("356124") != std::string::npos) fill_number = "6953";
-
   std::string stream = "???";
-  if (std::string(argv[1]).find("express") != std::string::npos) stream = "express_express";
-  if (std::string(argv[1]).find("zerobias") != std::string::npos) stream = "physics_ZeroBias";
-  if (std::string(argv[1]).find("enhanced") != std::string::npos) stream = "physics_EnhancedBias";
+  try {
+    RunIndex index{"output/run_index.txt"};
+    index.loadFillTable("data/fills.txt");
+    const auto& entry = index.updateFile(args.at(0));
+    index.save();
+    if (entry.run != std::stoi(args.at(1))) {
+      std::cerr << "Warning: file is indexed with run " << entry.run << std::endl;
+    }
+    fill_number = entry.fill;
+    stream = entry.stream;
+  } catch (const std::exception& e) {
+    std::cerr << "Warning: " << e.what() << ", fill and stream are unknown" << std::endl;
+  }
 
   // Set up the canvases and legends
   // ---------------------------------------------------------
@@ -66,61 +92,66 @@ int main(int argc, char** argv) {
   left_legend.SetTextFont(42);
   left_legend.SetTextSize(0.05);
 
-  std::set<int> vetoed_lbs;
-  for (int i = 0; i < 246; ++i) {
-    vetoed_lbs.insert(i);
-  }
+  // Find the lumi blocks to veto (e.g. where the stream is not
+  // yet active) from the LB activity of all modules.
+  // ---------------------------------------------------------
+  DirectoryParser all_modules{file, path};
+  LumiBlockVeto veto{file, path, all_modules.modules};
+  const auto vetoed_lbs = veto.findVetoedLumiBlocks();
 
   // Here the actual setup of the plots is done.
   // -------------------------------------------------------
   const double pile_up_min = 22.5;
   const double pile_up_max = 57.5;
-  const int n_bins_from_zero = std::floor((pile_up_max + 2.5)/5);
+  PileUpExtractor extractor{file, path};
+  extractor.vetoLumiBlocks(vetoed_lbs);
+  extractor.setPileUpRange(pile_up_min, pile_up_max);
+
+  // The bit-stream occupancy is always extracted, any additional
+  // per-module metrics (e.g. "Hits/Occupancy_per_module/") are
+  // extracted in the same traversal.
+  std::vector<std::string> metrics{kDefaultMetric};
+  for (std::size_t i = 2; i < args.size(); ++i) {
+    metrics.push_back(args.at(i));
+  }
+  extractor.setMetrics(metrics);
+
+  // The RDataFrame backend runs its event loop on all cores.
+  if (backend == PileUpExtractor::Backend::kDataFrame) {
+    std::cout << "Using the RDataFrame backend" << std::endl;
+    ROOT::EnableImplicitMT();
+  }
+  extractor.setBackend(backend);
 
   // What we do here is the following: we look for all
-  // module-granularity histograms that match the given wildcard.
-  // For these histograms, we map from luminosity vs. bandwidth
-  // usage to pile-up vs. bandwidth usage by using the
-  // luminosity/pile-up relation stored under Pixel/Hits/. After
-  // getting histograms for all modules individually, we reduce
-  // this infromation to _one_ histogram per given wildcard (e.g.
-  // for layers).
-  auto make_reduced_hist = [&] (const std::string& wildcard, const std::string& title) {
-    std::cout << "Producing pile-up histogram \"" << title;
-    std::cout <<"\" for modules: " << wildcard << std::endl;
-    DirectoryParser parser{file, path, wildcard};
-    TProfile prof{(title).c_str(), ("prof_" + title).c_str(), n_bins_from_zero, -2.5, pile_up_max, "s"};
-    for (const auto& module : parser.modules) {
-      PileUpHistogram hist{file, path, module};
-      hist.vetoLumiBlocks(vetoed_lbs);
-      hist.setPileUpRange(pile_up_min, pile_up_max);
-      hist.fillHisto();
-      for (int i = 1; i <= hist.getHisto()->GetNbinsX(); ++i) {
-        if (hist.getHisto()->GetBinContent(i) == 0) continue;
-        prof.Fill(hist.getHisto()->GetBinCenter(i), hist.getHisto()->GetBinContent(i));
-      }
-    }
-    auto projection = std::unique_ptr<TH1D>(prof.ProjectionX());
-    projection->SetName(prof.GetName());
-    projection->GetXaxis()->SetRangeUser(12.5, pile_up_max);
-    for (int i = 1; i <= projection->GetNbinsX(); ++i) {
-      projection->SetBinError(i, projection->GetBinError(i) * 3);
+  // module-granularity histograms of the module groups (e.g.
+  // layers). For these histograms, we map from luminosity vs.
+  // bandwidth usage to pile-up vs. bandwidth usage by using the
+  // luminosity/pile-up relation stored under Pixel/Hits/. All
+  // groups and metrics are extracted at once, such that
+  // tables[k][g] holds the modules of the k-th metric in the
+  // g-th group. After getting histograms for all modules
+  // individually, we reduce this infromation to _one_ histogram
+  // per group, i.e. reduced_hists[k] holds the histograms of the
+  // k-th metric.
+  std::cout << "Producing pile-up histograms for all module groups" << std::endl;
+  const auto tables = extractor.extractGroups(kPixelModuleGroups);
+  std::vector<std::vector<std::unique_ptr<TH1D> > > reduced_hists(metrics.size());
+  for (std::size_t k = 0; k < tables.size(); ++k) {
+    for (std::size_t g = 0; g < kPixelModuleGroups.size(); ++g) {
+      reduced_hists.at(k).emplace_back(extractor.makeReducedHist(tables.at(k).at(g), kPixelModuleGroups.at(g).title));
     }
-    return projection;
+  }
+  auto group_index = [] (const std::string& title) {
+    auto group = std::find_if(kPixelModuleGroups.begin(), kPixelModuleGroups.end(), [&] (const ModuleGroup& g) {
+      return g.title == title;
+    });
+    return static_cast<std::size_t>(group - kPixelModuleGroups.begin());
   };
 
   // Plots for: total bit-stream usage
   // -------------------------------------------------------
-  std::vector<std::unique_ptr<TH1D> > reduced_hists;
-  reduced_hists.emplace_back(make_reduced_hist("^L0", "L0"));
-  reduced_hists.emplace_back(make_reduced_hist("^L1", "L1"));
-  reduced_hists.emplace_back(make_reduced_hist("^L2", "L2"));
-  reduced_hists.emplace_back(make_reduced_hist("^ECA", "ECA"));
-  reduced_hists.emplace_back(make_reduced_hist("^ECC((?!S1_M[16]).)*$", "ECC"));
-  reduced_hists.emplace_back(make_reduced_hist("^LI.*_[AC][^(7|8)]_", "IBL2D"));
-  reduced_hists.emplace_back(make_reduced_hist("^LI.*_[AC][78]_", "IBL3D"));
-
-  HistStack stack{reduced_hists};
+  HistStack stack{reduced_hists.front()};
   stack.setXAxisTitle("Average #mu per lumi block");
   stack.setYAxisTitle("Average bandwidth usage");
   stack.setComfortableMax(0.7);
@@ -139,6 +170,84 @@ int main(int argc, char** argv) {
 
   std::cout << stack.printTable() << std::endl;
 
+  // Plots for: all additional metrics
+  // -------------------------------------------------------
+  for (std::size_t k = 1; k < metrics.size(); ++k) {
+    auto name = extractor.getMetrics().at(k);
+    name.pop_back();
+    std::replace(name.begin(), name.end(), '/', '_');
+
+    HistStack metric_stack{reduced_hists.at(k)};
+    metric_stack.setXAxisTitle("Average #mu per lumi block");
+    metric_stack.setYAxisTitle("Average " + name);
+    metric_stack.setXAxisTicks(210);
+    metric_stack.createLegend(&left_legend);
+    metric_stack.shift(std::vector<float>{+.00, +.00, -.16, -.16, +.16, -.08, +.08});
+    metric_stack.draw(&canvas);
+    left_legend.Draw("SAME");
+    ATLASLabel(0.2, 0.88, "Pixel Internal");
+    SupportLabel(0.2, 0.82, "Fill " + fill_number + ", " + stream);
+    canvas.SaveAs(("output/avg_" + name + "_vs_mu.pdf").c_str());
+    canvas.SaveAs(("output/avg_" + name + "_vs_mu.png").c_str());
+    left_legend.Clear();
+
+    std::cout << name << std::endl << metric_stack.printTable() << std::endl;
+  }
+
+  // Plots for: bit-stream usage per IBL stave
+  // -------------------------------------------------------
+  // The planar and 3D modules of each stave are merged into one
+  // histogram per stave (the second level of the module names).
+  // With one histogram per stave, the staves are drawn in pages
+  // of four, one page per pad, together with the envelope of all
+  // staves.
+  std::map<std::string, ModuleTable> staves;
+  for (const auto& title : {"IBL2D", "IBL3D"}) {
+    const auto& table = tables.front().at(group_index(title));
+    for (std::size_t m = 0; m < table.getNModules(); ++m) {
+      const auto& module = table.modules.at(m);
+      auto first = module.find('/');
+      auto stave_name = module.substr(first + 1, module.find('/', first + 1) - first - 1);
+      auto& stave = staves[stave_name];
+      if (stave.bin_centers.empty()) {
+        stave.metric = table.metric;
+        stave.bin_centers = table.bin_centers;
+        stave.pile_up_min = table.pile_up_min;
+        stave.pile_up_max = table.pile_up_max;
+      }
+      stave.modules.push_back(module);
+      auto row = table.values.begin() + m * table.getNBins();
+      stave.values.insert(stave.values.end(), row, row + table.getNBins());
+    }
+  }
+
+  std::vector<std::unique_ptr<TH1D> > stave_hists;
+  for (const auto& stave : staves) {
+    stave_hists.emplace_back(extractor.makeReducedHist(stave.second, stave.first));
+  }
+  if (!stave_hists.empty()) {
+    const unsigned int staves_per_page = 4;
+    HistStack stave_stack{stave_hists};
+    stave_stack.setXAxisTitle("Average #mu per lumi block");
+    stave_stack.setYAxisTitle("Average bandwidth usage");
+    stave_stack.setComfortableMax(stave_stack.getMax());
+    stave_stack.setXAxisTicks(210);
+    stave_stack.autoShift(0.32, staves_per_page);
+    TCanvas paged_canvas{"paged_canvas", "paged_canvas", 1200, 900};
+    std::cout << "Drawing " << stave_stack.getSize() << " IBL staves on ";
+    std::cout << stave_stack.getNPages(staves_per_page) << " pads" << std::endl;
+    stave_stack.drawPaged(&paged_canvas, staves_per_page, true);
+    paged_canvas.SaveAs("output/avg_bitstr_occ_vs_mu_ibl_staves.pdf");
+    paged_canvas.SaveAs("output/avg_bitstr_occ_vs_mu_ibl_staves.png");
+
+    stave_stack.drawEnvelope(&canvas);
+    ATLASLabel(0.2, 0.88, "Pixel Internal");
+    SupportLabel(0.2, 0.82, "Fill " + fill_number + ", " + stream);
+    SupportLabel(0.2, 0.76, "IBL, all staves");
+    canvas.SaveAs("output/avg_bitstr_occ_vs_mu_ibl_envelope.pdf");
+    canvas.SaveAs("output/avg_bitstr_occ_vs_mu_ibl_envelope.png");
+  }
+
 
   // Module-spread plots
   // -------------------------------------------------------
@@ -151,18 +260,11 @@ int main(int argc, char** argv) {
   // a file.
   std::ofstream data_output{"output/module_data.txt"};
   data_output << "Component\tPile-Up\tBandwidth Usage" << std::endl;
-  auto make_module_spread = [&] (const std::string& wildcard, float pile_up_val) {
+  auto make_module_spread = [&] (const ModuleTable& modules, float pile_up_val) {
     std::cout << "Producing module-spread plots with mu = ";
-    std::cout << pile_up_val << " for modules: " << wildcard << std::endl;
-    DirectoryParser parser{file, path, wildcard};
+    std::cout << pile_up_val << std::endl;
     auto spread = std::make_unique<TH1D>(std::tmpnam(nullptr), std::tmpnam(nullptr), 100, 0., 1.);
-    for (const auto& module : parser.modules) {
-      PileUpHistogram hist{file, path, module};
-      hist.vetoLumiBlocks(vetoed_lbs);
-      hist.setPileUpRange(pile_up_min, pile_up_max);
-      hist.fillHisto();
-      auto val = hist.getHisto()->GetBinContent(hist.getHisto()->FindBin(pile_up_val));
-      if (val == 0) continue;
+    for (const auto& val : extractor.getModuleValues(modules, pile_up_val)) {
       data_output << pile_up_val << "\t" << val << std::endl;
       spread->Fill(val);
     }
@@ -170,15 +272,18 @@ int main(int argc, char** argv) {
     return spread;
   };
 
-  // Now perform the actual steps.
+  // Now perform the actual steps. The modules of the IBL 3D
+  // group were already extracted above and are evaluated at the
+  // different pile-up values.
   // -------------------------------------------------------
-  auto spread = make_module_spread("^LI.*_[AC][78]_", 25);
-  spread = make_module_spread("^LI.*_[AC][78]_", 30);
-  spread = make_module_spread("^LI.*_[AC][78]_", 35);
-  spread = make_module_spread("^LI.*_[AC][78]_", 40);
-  spread = make_module_spread("^LI.*_[AC][78]_", 45);
-  spread = make_module_spread("^LI.*_[AC][78]_", 50);
-  spread = make_module_spread("^LI.*_[AC][78]_", 55);
+  const auto& ibl_3d_modules = tables.front().at(group_index("IBL3D"));
+  auto spread = make_module_spread(ibl_3d_modules, 25);
+  spread = make_module_spread(ibl_3d_modules, 30);
+  spread = make_module_spread(ibl_3d_modules, 35);
+  spread = make_module_spread(ibl_3d_modules, 40);
+  spread = make_module_spread(ibl_3d_modules, 45);
+  spread = make_module_spread(ibl_3d_modules, 50);
+  spread = make_module_spread(ibl_3d_modules, 55);
 
   data_output.close();
 